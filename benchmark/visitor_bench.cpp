@@ -0,0 +1,172 @@
+// Compares the traversal throughput of ast::Visitor and ast::StaticVisitor.
+// Generates a program with many methods, checks it and then runs the same
+// counting pass over all method bodies with both kinds of dispatch. Only the
+// bodies are traversed, like the hot passes do, since visiting the member
+// lists also sorts them and that would dominate for small methods.
+//
+// usage: visitor_bench [methods] [repetitions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "../src/ast.hpp"
+#include "../src/parser.hpp"
+#include "../src/semantic_visitor.hpp"
+#include "../src/static_visitor.hpp"
+
+namespace {
+
+struct Counts {
+  size_t blocks = 0, literals = 0, varRefs = 0, binaries = 0, calls = 0;
+
+  bool operator==(const Counts &o) const {
+    return blocks == o.blocks && literals == o.literals &&
+           varRefs == o.varRefs && binaries == o.binaries && calls == o.calls;
+  }
+  size_t total() const {
+    return blocks + literals + varRefs + binaries + calls;
+  }
+};
+
+// looks at a few node types like a typical pass, the rest is only traversed
+class VirtualCounter : public ast::Visitor {
+public:
+  Counts counts;
+
+  void visitBlock(ast::Block &block) override {
+    ++counts.blocks;
+    block.acceptChildren(this);
+  }
+  void visitIntLiteral(ast::IntLiteral &) override { ++counts.literals; }
+  void visitVarRef(ast::VarRef &) override { ++counts.varRefs; }
+  void visitBinaryExpression(ast::BinaryExpression &expr) override {
+    ++counts.binaries;
+    expr.acceptChildren(this);
+  }
+  void visitMethodInvocation(ast::MethodInvocation &invocation) override {
+    ++counts.calls;
+    invocation.acceptChildren(this);
+  }
+};
+
+class StaticCounter : public ast::StaticVisitor<StaticCounter> {
+public:
+  Counts counts;
+
+  void visitBlock(ast::Block &block) {
+    ++counts.blocks;
+    visitChildren(block);
+  }
+  void visitIntLiteral(ast::IntLiteral &) { ++counts.literals; }
+  void visitVarRef(ast::VarRef &) { ++counts.varRefs; }
+  void visitBinaryExpression(ast::BinaryExpression &expr) {
+    ++counts.binaries;
+    visitChildren(expr);
+  }
+  void visitMethodInvocation(ast::MethodInvocation &invocation) {
+    ++counts.calls;
+    visitChildren(invocation);
+  }
+};
+
+std::string generateProgram(int numMethods) {
+  std::ostringstream out;
+  out << "class Main {\n  public int f;\n  public int[] a;\n";
+  for (int i = 0; i < numMethods; ++i) {
+    out << "  public int m" << i << "(int x, int y) {\n"
+        << "    int z = x * 3 + y - " << i << ";\n"
+        << "    while (z < 1000 && !(z == y)) {\n"
+        << "      if (z % 2 == 0) {\n"
+        << "        z = z + a[z % 10] * (f - y) / 2;\n"
+        << "      } else {\n"
+        << "        z = -z + this.m" << (i + 1) % numMethods
+        << "(z, y + 1) + 7;\n"
+        << "      }\n"
+        << "    }\n"
+        << "    System.out.println(z);\n"
+        << "    return z;\n"
+        << "  }\n";
+  }
+  out << "  public static void main(String[] args) {\n"
+      << "    Main m = new Main();\n"
+      << "    m.a = new int[10];\n"
+      << "    m.m0(1, 2);\n"
+      << "  }\n}\n";
+  return out.str();
+}
+
+template <typename F> double measureMs(int repetitions, F &&run) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repetitions; ++i) {
+    run();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int numMethods = argc > 1 ? std::atoi(argv[1]) : 20000;
+  int repetitions = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  std::istringstream input(generateProgram(numMethods));
+  InputFile inputFile{"<generated>", &input};
+  SymbolTable::StringTable strTbl;
+  Parser parser{inputFile, strTbl};
+  auto ast = parser.parseProgram();
+  SemanticVisitor semantic(parser.getLexer());
+  ast->accept(&semantic);
+
+  std::vector<ast::Block *> bodies;
+  for (auto *klass : ast->getClasses()) {
+    for (auto *method : klass->getMethods()->methods) {
+      bodies.push_back(method->getBlock());
+    }
+    for (auto *mainMethod : klass->getMainMethods()->mainMethods) {
+      bodies.push_back(mainMethod->getBlock());
+    }
+  }
+
+  VirtualCounter virtualCounter;
+  StaticCounter staticCounter;
+  // the best of several alternating rounds, so other load on the machine
+  // affects both sides alike
+  const int rounds = 5;
+  double virtualMs = 0, staticMs = 0;
+  for (int round = 0; round < rounds; ++round) {
+    double ms = measureMs(repetitions, [&] {
+      virtualCounter.counts = {};
+      for (auto *body : bodies) {
+        body->accept(&virtualCounter);
+      }
+    });
+    virtualMs = round == 0 ? ms : std::min(virtualMs, ms);
+    ms = measureMs(repetitions, [&] {
+      staticCounter.counts = {};
+      for (auto *body : bodies) {
+        staticCounter.visitBlock(*body);
+      }
+    });
+    staticMs = round == 0 ? ms : std::min(staticMs, ms);
+  }
+
+  if (!(virtualCounter.counts == staticCounter.counts)) {
+    std::cerr << "ERROR: the visitors saw different nodes" << std::endl;
+    return EXIT_FAILURE;
+  }
+  size_t nodes = virtualCounter.counts.total() * repetitions;
+  std::cout << numMethods << " methods, best of " << rounds << " x "
+            << repetitions << " runs, "
+            << virtualCounter.counts.total() << " counted nodes per run\n"
+            << "  ast::Visitor:       " << virtualMs << " ms, "
+            << virtualMs * 1e6 / nodes << " ns/node\n"
+            << "  ast::StaticVisitor: " << staticMs << " ms, "
+            << staticMs * 1e6 / nodes << " ns/node\n"
+            << "  speedup: " << virtualMs / staticMs << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump pointer allocator: objects are placed one after another into large
+// blocks and are all released together with the arena. Destructors of objects
+// which need one run at that point, in reverse order of creation. Objects in
+// an arena must not own each other.
+class Arena {
+  static constexpr size_t blockSize = 64 * 1024;
+
+  struct Finalizer {
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char *cur = nullptr, *end = nullptr;
+  std::vector<Finalizer> finalizers;
+  size_t numObjects = 0;
+
+  void newBlock(size_t minSize) {
+    size_t size = minSize > blockSize ? minSize : blockSize;
+    blocks.emplace_back(new char[size]);
+    cur = blocks.back().get();
+    end = cur + size;
+  }
+
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena(Arena &&o)
+      : blocks(std::move(o.blocks)), cur(o.cur), end(o.end),
+        finalizers(std::move(o.finalizers)), numObjects(o.numObjects) {
+    o.blocks.clear();
+    o.cur = o.end = nullptr;
+    o.finalizers.clear();
+    o.numObjects = 0;
+  }
+  Arena &operator=(const Arena &) = delete;
+  ~Arena() {
+    for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it) {
+      it->destroy(it->object);
+    }
+  }
+
+  void *allocate(size_t size, size_t align) {
+    void *res = cur;
+    size_t space = end - cur;
+    if (!std::align(align, size, res, space)) {
+      newBlock(size + align);
+      res = cur;
+      space = end - cur;
+      std::align(align, size, res, space);
+    }
+    cur = static_cast<char *>(res) + size;
+    return res;
+  }
+
+  template <typename T, typename... Args> T *create(Args &&... args) {
+    T *obj = new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    ++numObjects;
+    if (!std::is_trivially_destructible<T>::value) {
+      finalizers.push_back({obj, [](void *p) { static_cast<T *>(p)->~T(); }});
+    }
+    return obj;
+  }
+
+  size_t getNumObjects() const { return numObjects; }
+  size_t getNumBlocks() const { return blocks.size(); }
+};
+
+#endif // ARENA_H
@@ -29,6 +29,10 @@ const Mnemonic *Movslq = new Mnemonic{ 21, "movslq" };
 const Mnemonic *Cqto   = new Mnemonic{ 22, "cqto" };
 
 const Mnemonic *Label = new Mnemonic{ 23, "______" };
+const Mnemonic *Sar   = new Mnemonic{ 24, "sar" };
+const Mnemonic *Shr   = new Mnemonic{ 25, "shr" };
+const Mnemonic *Shl   = new Mnemonic{ 26, "shl" };
+const Mnemonic *Lea   = new Mnemonic{ 27, "lea" };
 
 
 
@@ -135,6 +139,11 @@ std::ostream &operator<<(std::ostream &o, const Op &op) {
         o << op.ind.offset << '(' << getRegAsmName(op.ind.base, op.ind.mode) << ')';
       else
         o << '(' << getRegAsmName(op.ind.base, op.ind.mode) << ')';
+    break;
+      case OP_IDX:
+      o << '(' << getRegAsmName(op.idx.base, op.idx.mode) << ','
+        << getRegAsmName(op.idx.index, op.idx.mode) << ','
+        << (int)op.idx.scale << ')';
     break;
       case OP_STR:
       o << *(op.str.str);
@@ -60,6 +60,10 @@ extern const Mnemonic *Movb;
 extern const Mnemonic *Movslq;
 extern const Mnemonic *Cqto;
 extern const Mnemonic *Label;
+extern const Mnemonic *Sar;
+extern const Mnemonic *Shr;
+extern const Mnemonic *Shl;
+extern const Mnemonic *Lea;
 
 enum class RegName : uint8_t {
   ax,
@@ -94,6 +98,7 @@ enum OpType {
   OP_IMM,
   OP_REG,
   OP_IND,
+  OP_IDX,
   OP_STR,
   OP_NONE
 };
@@ -115,6 +120,12 @@ private:
     RegMode mode;
     int32_t offset;
   };
+  struct _idx {
+    RegName base;
+    RegName index;
+    RegMode mode;
+    uint8_t scale;
+  };
 public:
   OpType type = OP_NONE;
   union {
@@ -122,6 +133,7 @@ public:
     _str str;
     _reg reg;
     _ind ind;
+    _idx idx;
   };
 
   Op() { type = OP_NONE; str.str = nullptr; }
@@ -140,6 +152,14 @@ public:
     ind.mode = mode;
     ind.offset = offset;
   }
+  // (base,index,scale), only used with lea so far
+  Op(RegName base, RegName index, int scale, RegMode mode) {
+    type = OP_IDX;
+    idx.base = base;
+    idx.index = index;
+    idx.mode = mode;
+    idx.scale = scale;
+  }
   Op(const Op &src, int offset) {
     if (src.type == OP_IND) {
       type = OP_IND;
@@ -171,6 +191,9 @@ public:
       case OP_IND:
         ind = op.ind;
         break;
+      case OP_IDX:
+        idx = op.idx;
+        break;
       case OP_STR:
         if (op.str.str != nullptr) {
           str.str = new std::string(*op.str.str);
@@ -204,6 +227,9 @@ public:
       case OP_IND:
         ind = other.ind;
         break;
+      case OP_IDX:
+        idx = other.idx;
+        break;
       case OP_STR:
         str.str = new std::string(*other.str.str);
         break;
@@ -229,6 +255,9 @@ public:
       case OP_IND:
         ind = other.ind;
         break;
+      case OP_IDX:
+        idx = other.idx;
+        break;
       case OP_STR:
         str.str = new std::string(*other.str.str);
         break;
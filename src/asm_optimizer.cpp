@@ -562,13 +562,17 @@ void AsmAliasOptimizer::optimizeBlock(Asm::BasicBlock *block) {
       bool removeInstr = false;
 
 
-      for (size_t x = i + 1; x < block->flattenedInstrs.size() - 1; x ++) {
+      for (size_t x = i + 1; x < block->flattenedInstrs.size(); x ++) {
         auto instr2 = &block->flattenedInstrs.at(x);
         if (touchesReg(instr2, srcRegName)) {
           removeInstr = false;
           break;
         }
         if (touchesReg(instr2, dstRegName)) {
+          // Instructions like add or shl read the old value of reg2 before
+          // overwriting it, the mov is still needed for them.
+          if (!instr2->isMov())
+            removeInstr = false;
           break;
         }
 
@@ -583,6 +587,11 @@ void AsmAliasOptimizer::optimizeBlock(Asm::BasicBlock *block) {
           } else if (instr2->ops[opIdx].type == Asm::OP_IND &&
                      instr2->ops[opIdx].ind.base == dstRegName) {
             instr2->ops[opIdx].ind.base = srcRegName;
+          } else if (instr2->ops[opIdx].type == Asm::OP_IDX) {
+            if (instr2->ops[opIdx].idx.base == dstRegName)
+              instr2->ops[opIdx].idx.base = srcRegName;
+            if (instr2->ops[opIdx].idx.index == dstRegName)
+              instr2->ops[opIdx].idx.index = srcRegName;
           }
         }
         removeInstr = true;
@@ -78,11 +78,15 @@ void AsmPass::before() {
 }
 
 void AsmPass::visitMethod(ir_graph *graph) {
+  asmProgram.addFunction(generateFunction(graph, this->optimize));
+}
+
+Asm::Function AsmPass::generateFunction(ir_graph *graph, bool optimize) {
   const char *functionName = get_entity_ld_name(get_irg_entity(graph));
   Asm::Function func(functionName);
-  AsmMethodPass methodPass(graph, &func, this->optimize);
+  AsmMethodPass methodPass(graph, &func, optimize);
   methodPass.run();
-  asmProgram.addFunction(std::move(func));
+  return func;
 }
 
 void AsmMethodPass::before() {
@@ -155,6 +159,127 @@ void AsmMethodPass::visitSub(ir_node *node) {
   bb->pushInstr(Asm::Mov, Asm::rbx(), getNodeOp(node));
 }
 
+/* Moves the 32 bit value @op sign extended into the 64 bit register @reg */
+static void loadSignExtended(Asm::BasicBlock *bb, const Asm::Op &op,
+                             Asm::RegName reg) {
+  if (op.type == Asm::OP_IMM) {
+    bb->pushInstr(Asm::Mov, op, Asm::Op(reg, Asm::RegMode::R));
+
+    bb->pushInstr(Asm::Movslq,
+                  Asm::Op(reg, Asm::RegMode::E),
+                  Asm::Op(reg, Asm::RegMode::R));
+
+  } else {
+    bb->pushInstr(Asm::Movslq, op, Asm::Op(reg, Asm::RegMode::R));
+  }
+}
+
+static bool isPowerOfTwo(uint64_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+static unsigned floorLog2(uint64_t value) {
+  unsigned result = 0;
+  while (value >>= 1)
+    result ++;
+  return result;
+}
+
+/* Divides the sign extended 32 bit value in rax by the absolute value of
+ * @divisor without idiv, rounding towards zero like Java does. The quotient
+ * ends up in rcx, rax is left untouched. */
+static void generateConstQuotient(Asm::BasicBlock *bb, int divisor) {
+  // 64 bit, so INT_MIN has an absolute value as well
+  int64_t absDivisor = divisor < 0 ? -(int64_t)divisor : divisor;
+
+  bb->pushInstr(Asm::Mov, Asm::rax(), Asm::rcx());
+  if (absDivisor == 1)
+    return;
+
+  if (isPowerOfTwo(absDivisor)) {
+    // An arithmetic shift rounds towards negative infinity, so add
+    // divisor - 1 to negative dividends first.
+    unsigned shift = floorLog2(absDivisor);
+    bb->pushInstr(Asm::Sar, Asm::Op(63), Asm::rcx());
+    bb->pushInstr(Asm::Shr, Asm::Op(64 - shift), Asm::rcx());
+    bb->pushInstr(Asm::Add, Asm::rax(), Asm::rcx());
+    bb->pushInstr(Asm::Sar, Asm::Op(shift), Asm::rcx());
+    return;
+  }
+
+  // Multiply with 2^(32 + shift) / divisor rounded up and shift the result
+  // back, see Granlund and Montgomery, "Division by Invariant Integers using
+  // Multiplication". The magic number is below 2^32 and the dividend below
+  // 2^31, so the whole product fits into 64 bits and no multiply high is
+  // needed. Negative dividends are rounded towards negative infinity by the
+  // shift, which is corrected by adding one.
+  unsigned shift = floorLog2(absDivisor);
+  uint64_t magic = ((uint64_t)1 << (32 + shift)) / absDivisor + 1;
+  assert(magic >= ((uint64_t)1 << 31) && magic < ((uint64_t)1 << 32));
+
+  // movl zero extends, so the magic number doesn't need a 64 bit immediate
+  bb->pushInstr(Asm::Movl, Asm::Op((int)(uint32_t)magic),
+                Asm::Op(Asm::RegName::dx, Asm::RegMode::E));
+  bb->pushInstr(Asm::IMul, Asm::Op(Asm::RegName::dx, Asm::RegMode::R),
+                Asm::rcx());
+  bb->pushInstr(Asm::Sar, Asm::Op(32 + shift), Asm::rcx());
+  bb->pushInstr(Asm::Mov, Asm::rax(),
+                Asm::Op(Asm::RegName::dx, Asm::RegMode::R));
+  bb->pushInstr(Asm::Sar, Asm::Op(63),
+                Asm::Op(Asm::RegName::dx, Asm::RegMode::R));
+  bb->pushInstr(Asm::Sub, Asm::Op(Asm::RegName::dx, Asm::RegMode::R),
+                Asm::rcx());
+}
+
+/* Multiplies @factor with @constant into rbx using shifts, lea and add/sub.
+ * Returns false if the constant has no cheap decomposition. */
+static bool generateConstProduct(Asm::BasicBlock *bb, const Asm::Op &factor,
+                                 int constant) {
+  if (constant == 0) {
+    bb->pushInstr(Asm::Mov, Asm::Op(0), Asm::rbx());
+    return true;
+  }
+
+  // Only the lower 32 bits of the result are used, so INT_MIN works like
+  // any other negative constant.
+  int64_t absConstant = constant < 0 ? -(int64_t)constant : constant;
+  unsigned shift = 0;
+  while (absConstant % 2 == 0) {
+    absConstant /= 2;
+    shift ++;
+  }
+
+  if (absConstant == 1 || absConstant == 3 || absConstant == 5 ||
+      absConstant == 9) {
+    bb->pushInstr(Asm::Mov, factor, Asm::rbx());
+    if (absConstant != 1) {
+      // lea (%rbx,%rbx,2) is rbx * 3 and so on
+      bb->pushInstr(Asm::Lea,
+                    Asm::Op(Asm::RegName::bx, Asm::RegName::bx,
+                            absConstant - 1, Asm::RegMode::R),
+                    Asm::rbx());
+    }
+    if (shift > 0)
+      bb->pushInstr(Asm::Shl, Asm::Op(shift), Asm::rbx());
+  } else if (shift == 0 && (isPowerOfTwo(absConstant - 1) ||
+                            isPowerOfTwo(absConstant + 1))) {
+    // factor * (2^n + 1) or factor * (2^n - 1)
+    bool add = isPowerOfTwo(absConstant - 1);
+    bb->pushInstr(Asm::Mov, factor, Asm::rbx());
+    bb->pushInstr(Asm::Mov, factor, Asm::rcx());
+    bb->pushInstr(Asm::Shl,
+                  Asm::Op(floorLog2(add ? absConstant - 1 : absConstant + 1)),
+                  Asm::rbx());
+    bb->pushInstr(add ? Asm::Add : Asm::Sub, Asm::rcx(), Asm::rbx());
+  } else {
+    return false;
+  }
+
+  if (constant < 0)
+    bb->pushInstr(Asm::Neg, Asm::rbx());
+  return true;
+}
+
 void AsmMethodPass::visitDiv(ir_node *node) {
   PRINT_ORDER;
   auto bb = getBB(node);
@@ -162,45 +287,37 @@ void AsmMethodPass::visitDiv(ir_node *node) {
   auto regMode = Asm::getRegMode(node);
   auto leftOp = getNodeOp(get_Div_left(node));
   auto rightOp = getNodeOp(get_Div_right(node));
+  auto resultReg = Asm::RegName::ax;
 
   // Move left into rax
-  if (leftOp.type == Asm::OP_IMM) {
-    bb->pushInstr(Asm::Mov, leftOp, Asm::rax());
+  loadSignExtended(bb, leftOp, Asm::RegName::ax);
 
-    bb->pushInstr(Asm::Movslq,
-                  Asm::Op(Asm::RegName::ax, Asm::RegMode::E),
-                  Asm::rax());
+  if (optimize && rightOp.type == Asm::OP_IMM && rightOp.imm.value != 0) {
+    // Constant divisor, no idiv needed
+    generateConstQuotient(bb, rightOp.imm.value);
+    if (rightOp.imm.value < 0)
+      bb->pushInstr(Asm::Neg, Asm::rcx());
 
+    resultReg = Asm::RegName::cx;
   } else {
-    bb->pushInstr(Asm::Movslq, leftOp, Asm::rax());
-  }
+    // Right into rcx
+    loadSignExtended(bb, rightOp, Asm::RegName::cx);
 
-  // Right into rcx
-  if (rightOp.type == Asm::OP_IMM) {
-    bb->pushInstr(Asm::Mov, rightOp, Asm::rcx());
+    // "the instruction cqto is used to perform sign extension,
+    //  copying the sign bit of %rax into every bit of %rdx."
+    bb->pushInstr(Asm::Cqto);
 
-    bb->pushInstr(Asm::Movslq,
-                  Asm::Op(Asm::RegName::cx, Asm::RegMode::E),
-                  Asm::rcx());
-
-  } else {
-    bb->pushInstr(Asm::Movslq, rightOp, Asm::rcx());
+    // Div only takes one argument, divides rax by that and stores the result in rax
+    bb->pushInstr(Asm::Div, Asm::rcx());
   }
 
-  // "the instruction cqto is used to perform sign extension,
-  //  copying the sign bit of %rax into every bit of %rdx."
-  bb->pushInstr(Asm::Cqto);
-
-  // Div only takes one argument, divides rax by that and stores the result in rax
-  bb->pushInstr(Asm::Div, Asm::rcx());
-
-  // division result is in rax
+  // division result is in resultReg
   ir_node *succ = getSucc(node, iro_Proj, mode_Ls);
   // no successor if the div result is unused
   if (succ != nullptr) {
     assert(is_Proj(succ));
     bb->pushInstr(Asm::Movq,
-                  Asm::Op(Asm::RegName::ax, regMode),
+                  Asm::Op(resultReg, regMode),
                   getNodeOp(succ));
   }
 }
@@ -212,45 +329,45 @@ void AsmMethodPass::visitMod(ir_node *node) {
   auto regMode = Asm::getRegMode(node);
   auto leftOp = getNodeOp(get_Mod_left(node));
   auto rightOp = getNodeOp(get_Mod_right(node));
+  auto resultReg = Asm::RegName::dx;
 
   // Move left into rax
-  if (leftOp.type == Asm::OP_IMM) {
-    bb->pushInstr(Asm::Mov, leftOp, Asm::rax());
-
-    bb->pushInstr(Asm::Movslq,
-                  Asm::Op(Asm::RegName::ax, Asm::RegMode::E),
-                  Asm::rax());
+  loadSignExtended(bb, leftOp, Asm::RegName::ax);
+
+  if (optimize && rightOp.type == Asm::OP_IMM && rightOp.imm.value != 0) {
+    // Constant divisor, the rest is left - quotient * divisor. The sign of
+    // the divisor doesn't matter for the rest.
+    int divisor = rightOp.imm.value;
+    int64_t absDivisor = divisor < 0 ? -(int64_t)divisor : divisor;
+    generateConstQuotient(bb, divisor);
+    if (isPowerOfTwo(absDivisor)) {
+      if (absDivisor > 1)
+        bb->pushInstr(Asm::Shl, Asm::Op(floorLog2(absDivisor)), Asm::rcx());
+    } else {
+      bb->pushInstr(Asm::IMul, Asm::Op((int)absDivisor), Asm::rcx());
+    }
+    bb->pushInstr(Asm::Sub, Asm::rcx(), Asm::rax());
 
+    resultReg = Asm::RegName::ax;
   } else {
-    bb->pushInstr(Asm::Movslq, leftOp, Asm::rax());
-  }
+    // Right into rcx
+    loadSignExtended(bb, rightOp, Asm::RegName::cx);
 
-  // Right into rcx
-  if (rightOp.type == Asm::OP_IMM) {
-    bb->pushInstr(Asm::Mov, rightOp, Asm::rcx());
-
-    bb->pushInstr(Asm::Movslq,
-                  Asm::Op(Asm::RegName::cx, Asm::RegMode::E),
-                  Asm::rcx());
+    // "the instruction cqto is used to perform sign extension,
+    //  copying the sign bit of %rax into every bit of %rdx."
+    bb->pushInstr(Asm::Cqto);
 
-  } else {
-    bb->pushInstr(Asm::Movslq, rightOp, Asm::rcx());
+    // Div only takes one argument, divides rax by that and stores the result in rax
+    bb->pushInstr(Asm::Div, Asm::rcx());
   }
 
-  // "the instruction cqto is used to perform sign extension,
-  //  copying the sign bit of %rax into every bit of %rdx."
-  bb->pushInstr(Asm::Cqto);
-
-  // Div only takes one argument, divides rax by that and stores the result in rax
-  bb->pushInstr(Asm::Div, Asm::rcx());
-
-  // division rest is in rdx
+  // division rest is in resultReg
   ir_node *succ = getSucc(node, iro_Proj, mode_Ls);
   assert(is_Proj(succ));
   // no successor if the div result is unused
   if (succ != nullptr) {
     bb->pushInstr(Asm::Movq,
-                  Asm::Op(Asm::RegName::dx, regMode),
+                  Asm::Op(resultReg, regMode),
                   getNodeOp(succ));
   }
 }
@@ -259,6 +376,18 @@ void AsmMethodPass::visitMul(ir_node *node) {
   PRINT_ORDER;
   auto bb = getBB(node);
 
+  auto leftOp = getNodeOp(get_Mul_left(node));
+  auto rightOp = getNodeOp(get_Mul_right(node));
+  if (leftOp.type == Asm::OP_IMM) {
+    std::swap(leftOp, rightOp);
+  }
+
+  if (optimize && rightOp.type == Asm::OP_IMM && leftOp.type != Asm::OP_IMM &&
+      generateConstProduct(bb, leftOp, rightOp.imm.value)) {
+    bb->pushInstr(Asm::Mov, Asm::rbx(), getNodeOp(node));
+    return;
+  }
+
   bb->pushInstr(Asm::Mov, getNodeOp(get_Mul_right(node)), Asm::rbx());
   bb->pushInstr(Asm::IMul, getNodeOp(get_Mul_left(node)), Asm::rbx());
   bb->pushInstr(Asm::Mov, Asm::rbx(), getNodeOp(node));
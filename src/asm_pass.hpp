@@ -29,6 +29,9 @@ public:
   void before();
   void visitMethod(ir_graph *graph);
 
+  // generates the code of a single graph
+  static Asm::Function generateFunction(ir_graph *graph, bool optimize);
+
   Asm::Program *getProgram() { return &asmProgram; }
 
 private:
@@ -1,5 +1,8 @@
 #include "ast.hpp"
 
+#include <unordered_map>
+#include <vector>
+
 SymbolTable::Symbol ast::DummyDefinition::dummySymbol("<Dummy>");
 SymbolTable::Symbol ast::DummySystemOut::dummySymbol("System.out");
 SymbolTable::Symbol ast::DummySystemIn::dummySymbol("System.in");
@@ -8,6 +11,39 @@ ast::DummyDefinition ast::VarRef::dummySystem;
 ast::DummySystemOut ast::FieldAccess::dummySystemOut;
 ast::DummySystemIn  ast::FieldAccess::dummySystemIn;
 
+namespace {
+// function local, AST nodes may be created during static initialization
+struct ClassNameTable {
+  std::unordered_map<std::string, sem::ClassNames::Id> ids;
+  // points into the keys of ids, which never move
+  std::vector<const std::string *> names;
+
+  ClassNameTable() {
+    auto pos = ids.emplace("", 0).first;
+    names.push_back(&pos->first);
+  }
+};
+ClassNameTable &classNameTable() {
+  static ClassNameTable table;
+  return table;
+}
+}
+
+sem::ClassNames::Id sem::ClassNames::intern(const std::string &name) {
+  auto &table = classNameTable();
+  auto pos = table.ids.emplace(name, table.names.size()).first;
+  if (pos->second == table.names.size()) {
+    table.names.push_back(&pos->first);
+  }
+  return pos->second;
+}
+
+const std::string &sem::ClassNames::get(Id id) {
+  auto &table = classNameTable();
+  assert(id < table.names.size());
+  return *table.names[id];
+}
+
 static const char *typeKindToString(sem::TypeKind kind) {
   switch (kind) {
   case sem::TypeKind::Bool:
@@ -41,11 +77,11 @@ std::ostream &operator<<(std::ostream &o, const sem::Type &t) {
     return o << typeKindToString(t.kind);
 
   case sem::TypeKind::Class:
-    return o << typeKindToString(t.kind) << "(" << t.name << ")";
+    return o << typeKindToString(t.kind) << "(" << t.getClassName() << ")";
   case sem::TypeKind::Array:
     o << typeKindToString(t.innerKind);
     if (t.innerKind == sem::TypeKind::Class) {
-      o << "(" << t.name << ")";
+      o << "(" << t.getClassName() << ")";
     }
     for (int i = 0; i < t.dimension; i++)
       o << "[]";
@@ -137,5 +173,8 @@ void Visitor::visitBinaryExpression(BinaryExpression &binaryExpression) {
 void Visitor::visitUnaryExpression(UnaryExpression &unaryExpression) {
   unaryExpression.acceptChildren(this);
 }
+void Visitor::visitExpression(Expression &expression) {
+  expression.accept(this);
+}
 
 } /* namespace ast */
@@ -28,14 +28,18 @@
 #define AST_H
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <type_traits>
 
+#include "arena.hpp"
 #include "lexer.hpp"
+#include "symbol_map.hpp"
 #include "symboltable.hpp"
 
 namespace sem {
-enum class TypeKind {
+enum class TypeKind : uint8_t {
   Array,
   Class,
   Bool,
@@ -45,27 +49,39 @@ enum class TypeKind {
   Unresolved
 };
 
+// Global table of class names. Each distinct name gets a small id, so types
+// can refer to classes by number and compare them without touching strings.
+// Id 0 is the empty name and means "no class". Names are only added while
+// building the AST, later phases just look them up.
+class ClassNames {
+public:
+  using Id = uint32_t;
+  static Id intern(const std::string &name);
+  static const std::string &get(Id id);
+};
+
 struct Type {
   TypeKind kind;
   // For arrays, e.g. int[] -> innerKind=int
   TypeKind innerKind = TypeKind::Unresolved;
-  // Both class types and arrays need a name
-  std::string name;
-  int dimension = 0;
+  uint16_t dimension = 0;
+  // Both class types and arrays of classes need a class, see ClassNames
+  ClassNames::Id classId = 0;
   Type() { kind = TypeKind::Unresolved; }
 
   void setInt() { kind = TypeKind::Int; }
   void setBool() { kind = TypeKind::Bool; }
-  void setArray(TypeKind innerKind, int dimension, std::string name = "") {
+  void setArray(TypeKind innerKind, int dimension, ClassNames::Id classId = 0) {
     assert(innerKind != TypeKind::Array);
+    assert(dimension > 0 && dimension <= UINT16_MAX);
     this->kind = TypeKind::Array;
-    this->name = name;
+    this->classId = classId;
     this->innerKind = innerKind;
     this->dimension = dimension;
   }
-  void setClass(std::string name) {
+  void setClass(ClassNames::Id classId) {
     this->kind = TypeKind::Class;
-    this->name = name;
+    this->classId = classId;
   }
   void setNull() { kind = TypeKind::Null; }
   void setVoid() { kind = TypeKind::Void; }
@@ -79,6 +95,8 @@ struct Type {
   bool isVoidArray() const { return isArray() && innerKind == TypeKind::Void; }
   bool isVoidOrVoidArray() const { return isVoid() || isVoidArray(); }
 
+  const std::string &getClassName() const { return ClassNames::get(classId); }
+
   Type getArrayInnerType() const {
     assert(kind == TypeKind::Array && dimension > 0);
     Type res = *this;
@@ -94,14 +112,14 @@ struct Type {
   bool operator==(const sem::Type &other) const {
     switch (this->kind) {
     case TypeKind::Class:
-      return other.kind == TypeKind::Class && this->name == other.name;
+      return other.kind == TypeKind::Class && this->classId == other.classId;
     case TypeKind::Array:
       if (other.kind != TypeKind::Array || this->dimension != other.dimension ||
           this->innerKind != other.innerKind) {
         return false;
       }
       if (this->innerKind == TypeKind::Class) {
-        return this->name == other.name;
+        return this->classId == other.classId;
       } else {
         return true;
       }
@@ -136,6 +154,9 @@ struct Type {
     __builtin_trap();
   }
 };
+static_assert(sizeof(Type) == 8, "sem::Type should stay small");
+static_assert(std::is_trivially_copyable<Type>::value,
+              "sem::Type should be copied as plain bytes");
 
 enum class ControlFlowBehavior {
   MayContinue, // code flow continues after the statement
@@ -154,40 +175,73 @@ inline ControlFlowBehavior combineCFB(ControlFlowBehavior c1,
 std::ostream &operator<<(std::ostream &o, const sem::Type &t);
 
 namespace ast {
-struct SortUniquePtrPred {
-  template <typename T>
-  bool operator()(const std::unique_ptr<T> &lhs,
-                  const std::unique_ptr<T> &rhs) const {
+struct SortPtrPred {
+  template <typename T> bool operator()(const T *lhs, const T *rhs) const {
     return *lhs < *rhs;
   }
 };
-struct UniquePtrEqPred {
-  template <typename T>
-  bool operator()(const std::unique_ptr<T> &lhs,
-                  const std::unique_ptr<T> &rhs) const {
-    return *lhs == *rhs;
-  }
-};
 
 class Visitor;
 
+// one tag per concrete node class, so a pass can dispatch with a switch
+// instead of a virtual call (see StaticVisitor)
+enum class NodeKind : uint8_t {
+  Program,
+  Class,
+  FieldList,
+  MethodList,
+  MainMethodList,
+  Field,
+  RegularMethod,
+  MainMethod,
+  Parameter,
+  PrimitiveType,
+  ClassType,
+  ArrayType,
+  Block,
+  VariableDeclaration,
+  ExpressionStatement,
+  IfStatement,
+  WhileStatement,
+  ReturnStatement,
+  NewArrayExpression,
+  NewObjectExpression,
+  IntLiteral,
+  BoolLiteral,
+  NullLiteral,
+  ThisLiteral,
+  VarRef,
+  MethodInvocation,
+  FieldAccess,
+  ArrayAccess,
+  BinaryExpression,
+  UnaryExpression
+};
+
 class Node {
+  NodeKind kind;
+
 protected:
   SourceLocation location;
 
-  Node(SourceLocation loc) : location(std::move(loc)) {}
+  Node(NodeKind kind, SourceLocation loc)
+      : kind(kind), location(std::move(loc)) {}
 
 public:
   virtual void accept(Visitor *) {}
   virtual void acceptChildren(Visitor *) {}
   virtual ~Node() = default;
+  NodeKind getKind() const { return kind; }
   const SourceLocation &getLoc() const { return location; }
 };
-using NodePtr = std::unique_ptr<Node>;
+// all nodes are created in the arena of their Program and released with it,
+// the pointers between nodes are not owning
+using NodePtr = Node *;
 
 class Program;
 class Block;
 class BlockStatement;
+class Expression;
 class Class;
 class FieldList;
 class MethodList;
@@ -216,7 +270,7 @@ class FieldAccess;
 class ArrayAccess;
 class BinaryExpression;
 class UnaryExpression;
-using ClassPtr = std::unique_ptr<Class>;
+using ClassPtr = Class *;
 
 class SemanticError : public CompilerError {
 public:
@@ -276,47 +330,60 @@ public:
   virtual void visitArrayAccess(ArrayAccess &arrayAccess);
   virtual void visitBinaryExpression(BinaryExpression &binaryExpression);
   virtual void visitUnaryExpression(UnaryExpression &unaryExpression);
+  // called by statements for their expressions, so a visitor can traverse
+  // expression trees without recursion (see Expression::expandChildren)
+  virtual void visitExpression(Expression &expression);
 };
 
 class Type : public Node {
 protected:
-  Type(SourceLocation loc) : Node(std::move(loc)) {}
+  Type(NodeKind kind, SourceLocation loc) : Node(kind, std::move(loc)) {}
 
 public:
   virtual sem::Type getSemaType() const = 0;
   virtual std::string getMangledName() const = 0;
 };
-using TypePtr = std::unique_ptr<Type>;
+using TypePtr = Type *;
 
 class BlockStatement : public Node {
 protected:
-  BlockStatement(SourceLocation loc) : Node(std::move(loc)) {}
+  BlockStatement(NodeKind kind, SourceLocation loc)
+      : Node(kind, std::move(loc)) {}
 
 public:
   sem::ControlFlowBehavior cfb = sem::ControlFlowBehavior::MayContinue;
 };
-using BlockStmtPtr = std::unique_ptr<BlockStatement>;
+using BlockStmtPtr = BlockStatement *;
 
 class Statement : public BlockStatement {
 protected:
-  Statement(SourceLocation loc) : BlockStatement(std::move(loc)) {}
+  Statement(NodeKind kind, SourceLocation loc)
+      : BlockStatement(kind, std::move(loc)) {}
 };
-using StmtPtr = std::unique_ptr<Statement>;
+using StmtPtr = Statement *;
 
 class Expression : public Node {
 public:
   sem::Type targetType;
 
+  // For traversals with an explicit stack instead of recursion: visits the
+  // children which are not expressions and pushes the subexpressions in
+  // reverse order of acceptChildren, so they are popped in the same order.
+  virtual void expandChildren(Visitor *, std::vector<Expression *> &) {}
+  // pushes the addresses of the pointers to the subexpressions, for passes
+  // which replace subexpressions (see ConstantFolder)
+  virtual void expandChildSlots(std::vector<Expression **> &) {}
+
 protected:
-  Expression(SourceLocation loc) : Node(std::move(loc)) {}
+  Expression(NodeKind kind, SourceLocation loc) : Node(kind, std::move(loc)) {}
 };
 
 class RValueExpression : public Expression {
 public:
-  RValueExpression(SourceLocation loc) : Expression(loc) {}
+  RValueExpression(NodeKind kind, SourceLocation loc) : Expression(kind, loc) {}
 };
 
-using ExprPtr = std::unique_ptr<Expression>;
+using ExprPtr = Expression *;
 using ExprList = std::vector<ExprPtr>;
 
 using BlockStmtList = std::vector<BlockStmtPtr>;
@@ -326,7 +393,8 @@ class Block : public Statement {
 
 public:
   Block(SourceLocation loc, BlockStmtList statements, bool flag)
-      : Statement(std::move(loc)), statements(std::move(statements)),
+      : Statement(NodeKind::Block, std::move(loc)),
+        statements(std::move(statements)),
         containsNothingExceptOneSingleLonelyEmtpyExpression(flag) {}
 
   BlockStmtList &getStatements() { return statements; }
@@ -343,13 +411,13 @@ public:
     }
   }
 };
-using BlockPtr = std::unique_ptr<Block>;
+using BlockPtr = Block *;
 
 class BasicType : public Type {
 protected:
-  BasicType(SourceLocation loc) : Type(std::move(loc)) {}
+  BasicType(NodeKind kind, SourceLocation loc) : Type(kind, std::move(loc)) {}
 };
-using BasicTypePtr = std::unique_ptr<BasicType>;
+using BasicTypePtr = BasicType *;
 
 class PrimitiveType : public BasicType {
 public:
@@ -360,7 +428,7 @@ private:
 
 public:
   PrimitiveType(SourceLocation loc, PrimType type)
-      : BasicType(std::move(loc)), type(type) {}
+      : BasicType(NodeKind::PrimitiveType, std::move(loc)), type(type) {}
 
   static PrimType getTypeForToken(Token::Type t) {
     switch (t) {
@@ -419,13 +487,16 @@ public:
 
 class ClassType : public BasicType {
   std::string name;
+  sem::ClassNames::Id classId;
   Class *classDef = nullptr;
 
 public:
   ClassType(SourceLocation loc, std::string name)
-      : BasicType(std::move(loc)), name(std::move(name)) {}
+      : BasicType(NodeKind::ClassType, std::move(loc)), name(std::move(name)),
+        classId(sem::ClassNames::intern(this->name)) {}
 
   const std::string &getName() const { return name; }
+  sem::ClassNames::Id getClassId() const { return classId; }
 
   void accept(Visitor *visitor) override { visitor->visitClassType(*this); }
   void setDef(Class *def) { classDef = def; }
@@ -433,7 +504,7 @@ public:
 
   sem::Type getSemaType() const override {
     sem::Type res;
-    res.setClass(getName());
+    res.setClass(classId);
     return res;
   }
 
@@ -448,9 +519,9 @@ class ArrayType : public Type {
 
 public:
   ArrayType(SourceLocation loc, BasicTypePtr elementType, int dimension)
-      : Type(std::move(loc)), elementType(std::move(elementType)),
-        dimension(dimension) {}
-  BasicType *getElementType() const { return elementType.get(); }
+      : Type(NodeKind::ArrayType, std::move(loc)),
+        elementType(std::move(elementType)), dimension(dimension) {}
+  BasicType *getElementType() const { return elementType; }
   int getDimension() const { return dimension; }
 
   void accept(Visitor *visitor) override { visitor->visitArrayType(*this); }
@@ -461,7 +532,7 @@ public:
   sem::Type getSemaType() const override {
     sem::Type res;
     auto innerType = elementType->getSemaType();
-    res.setArray(innerType.kind, dimension, innerType.name);
+    res.setArray(innerType.kind, dimension, innerType.classId);
     return res;
   }
 
@@ -469,23 +540,25 @@ public:
     return std::string(dimension, 'P') + elementType->getMangledName();
   }
 };
-using ArrayTypePtr = std::unique_ptr<ArrayType>;
+using ArrayTypePtr = ArrayType *;
 
 class ExpressionStatement : public Statement {
   ExprPtr expr;
 
 public:
   ExpressionStatement(SourceLocation loc, ExprPtr expr)
-      : Statement(std::move(loc)), expr(std::move(expr)) {}
+      : Statement(NodeKind::ExpressionStatement, std::move(loc)),
+        expr(std::move(expr)) {}
 
-  Expression *getExpression() const { return expr.get(); }
+  Expression *getExpression() const { return expr; }
+  void setExpression(ExprPtr e) { expr = e; }
 
   void accept(Visitor *visitor) override {
     visitor->visitExpressionStatement(*this);
   }
 
   void acceptChildren(Visitor *visitor) override {
-    this->expr->accept(visitor);
+    visitor->visitExpression(*expr);
   }
 };
 
@@ -497,16 +570,20 @@ class IfStatement : public Statement {
 public:
   IfStatement(SourceLocation loc, ExprPtr condition, StmtPtr thenStmt,
               StmtPtr elseStmt)
-      : Statement(std::move(loc)), condition(std::move(condition)),
-        thenStmt(std::move(thenStmt)), elseStmt(std::move(elseStmt)) {}
+      : Statement(NodeKind::IfStatement, std::move(loc)),
+        condition(std::move(condition)), thenStmt(std::move(thenStmt)),
+        elseStmt(std::move(elseStmt)) {}
 
-  Expression *getCondition() const { return condition.get(); }
-  Statement *getThenStatement() const { return thenStmt.get(); }
-  Statement *getElseStatement() const { return elseStmt.get(); }
+  Expression *getCondition() const { return condition; }
+  Statement *getThenStatement() const { return thenStmt; }
+  Statement *getElseStatement() const { return elseStmt; }
+  void setCondition(ExprPtr cond) { condition = cond; }
+  void setThenStatement(StmtPtr stmt) { thenStmt = stmt; }
+  void setElseStatement(StmtPtr stmt) { elseStmt = stmt; }
 
   void accept(Visitor *visitor) override { visitor->visitIfStatement(*this); }
   void acceptChildren(Visitor *visitor) override {
-    condition->accept(visitor);
+    visitor->visitExpression(*condition);
     if (thenStmt != nullptr)
       thenStmt->accept(visitor);
 
@@ -521,18 +598,20 @@ class WhileStatement : public Statement {
 
 public:
   WhileStatement(SourceLocation loc, ExprPtr condition, StmtPtr statement)
-      : Statement(std::move(loc)), condition(std::move(condition)),
-        statement(std::move(statement)) {}
+      : Statement(NodeKind::WhileStatement, std::move(loc)),
+        condition(std::move(condition)), statement(std::move(statement)) {}
 
-  Expression *getCondition() const { return condition.get(); }
-  Statement *getStatement() const { return statement.get(); }
+  Expression *getCondition() const { return condition; }
+  Statement *getStatement() const { return statement; }
+  void setCondition(ExprPtr cond) { condition = cond; }
+  void setStatement(StmtPtr stmt) { statement = stmt; }
 
   void accept(Visitor *visitor) override {
     visitor->visitWhileStatement(*this);
   }
 
   void acceptChildren(Visitor *visitor) override {
-    condition->accept(visitor);
+    visitor->visitExpression(*condition);
     if (statement != nullptr)
       statement->accept(visitor);
   }
@@ -544,8 +623,10 @@ class ReturnStatement : public Statement {
 
 public:
   ReturnStatement(SourceLocation loc, ExprPtr expr)
-      : Statement(std::move(loc)), expr(std::move(expr)) {}
-  Expression *getExpression() const { return expr.get(); }
+      : Statement(NodeKind::ReturnStatement, std::move(loc)),
+        expr(std::move(expr)) {}
+  Expression *getExpression() const { return expr; }
+  void setExpression(ExprPtr e) { expr = e; }
 
   void accept(Visitor *visitor) override {
     visitor->visitReturnStatement(*this);
@@ -553,7 +634,7 @@ public:
 
   void acceptChildren(Visitor *visitor) override {
     if (expr != nullptr)
-      expr->accept(visitor);
+      visitor->visitExpression(*expr);
   }
 };
 
@@ -563,11 +644,12 @@ class Field : public Node, public SymbolTable::Definition {
 
 public:
   Field(SourceLocation loc, TypePtr type, SymbolTable::Symbol &sym)
-      : Node(std::move(loc)), type(std::move(type)), symbol(sym) {}
+      : Node(NodeKind::Field, std::move(loc)), type(std::move(type)),
+        symbol(sym) {}
 
   const std::string &getName() const { return symbol.name; }
   SymbolTable::Symbol &getSymbol() const override { return symbol; }
-  Type *getType() const override { return type.get(); }
+  Type *getType() const override { return type; }
 
   void accept(Visitor *visitor) override { visitor->visitField(*this); }
 
@@ -576,7 +658,7 @@ public:
   bool operator<(const Field &o) const { return symbol.name < o.symbol.name; }
   bool operator==(const Field &o) const { return symbol.name == o.symbol.name; }
 };
-using FieldPtr = std::unique_ptr<Field>;
+using FieldPtr = Field *;
 
 class Parameter : public Node, public SymbolTable::Definition {
   TypePtr type;
@@ -585,24 +667,26 @@ class Parameter : public Node, public SymbolTable::Definition {
 
 public:
   Parameter(SourceLocation loc, TypePtr type, SymbolTable::Symbol &sym, int idx)
-      : Node(std::move(loc)), type(std::move(type)), symbol(sym), idx(idx) {}
+      : Node(NodeKind::Parameter, std::move(loc)), type(std::move(type)),
+        symbol(sym), idx(idx) {}
 
   void accept(Visitor *visitor) override { visitor->visitParameter(*this); }
   void acceptChildren(Visitor *visitor) override { type->accept(visitor); }
   const std::string &getName() const { return symbol.name; }
   SymbolTable::Symbol &getSymbol() const override { return symbol; }
-  Type *getType() const override { return type.get(); }
+  Type *getType() const override { return type; }
   int getIndex() const { return idx; }
 };
-using ParameterPtr = std::unique_ptr<Parameter>;
+using ParameterPtr = Parameter *;
 using ParameterList = std::vector<ParameterPtr>;
 
 class Method : public Node {
   std::vector<VariableDeclaration* > varDecls;
 public:
-  Method(SourceLocation loc) : Node(loc) {}
+  Method(NodeKind kind, SourceLocation loc) : Node(kind, loc) {}
   virtual Type *getReturnType() const = 0;
   virtual const std::string &getName() const = 0;
+  virtual Block *getBlock() const = 0;
 
   bool operator<(const Method &o) const { return getName() < o.getName(); }
 
@@ -614,27 +698,29 @@ public:
 
 class RegularMethod : public Method {
   TypePtr returnType;
-  std::string name;
+  SymbolTable::Symbol &symbol;
   std::string mangledName;
   // might be empty
   ParameterList parameters;
   BlockPtr block;
 
 public:
-  RegularMethod(SourceLocation loc, TypePtr returnType, std::string name,
-                ParameterList parameters, BlockPtr block)
-      : Method(std::move(loc)), returnType(std::move(returnType)),
-        name(std::move(name)), parameters(std::move(parameters)),
-        block(std::move(block)) {}
-
-  const std::string &getName() const override { return name; }
-  Type *getReturnType() const override { return returnType.get(); }
-  Block *getBlock() const { return block.get(); }
+  RegularMethod(SourceLocation loc, TypePtr returnType,
+                SymbolTable::Symbol &sym, ParameterList parameters,
+                BlockPtr block)
+      : Method(NodeKind::RegularMethod, std::move(loc)),
+        returnType(std::move(returnType)), symbol(sym),
+        parameters(std::move(parameters)), block(std::move(block)) {}
+
+  const std::string &getName() const override { return symbol.name; }
+  SymbolTable::Symbol &getSymbol() const { return symbol; }
+  Type *getReturnType() const override { return returnType; }
+  Block *getBlock() const override { return block; }
 
   const ParameterList &getParameters() const { return parameters; }
 
   bool operator==(const RegularMethod &other) const {
-    return name == other.name;
+    return &symbol == &other.symbol;
   }
 
   void accept(Visitor *visitor) override { visitor->visitRegularMethod(*this); }
@@ -648,6 +734,7 @@ public:
   }
 
   void createMangledName(std::string className) {
+    auto &name = symbol.name;
     std::stringstream mName;
     mName << "_ZN" << className.length() << className << name.length() << name;
     mName << "E";
@@ -663,52 +750,49 @@ public:
   }
   std::string getMangledName() const { return mangledName; }
 };
-using RegularMethodPtr = std::unique_ptr<RegularMethod>;
+using RegularMethodPtr = RegularMethod *;
 
 class MainMethod : public Method {
-  std::string name;
+  SymbolTable::Symbol &symbol;
   SymbolTable::Symbol &argSymbol;
   BlockPtr block;
 
 public:
-  MainMethod(SourceLocation loc, std::string name, SymbolTable::Symbol &argName,
-             BlockPtr block)
-      : Method(std::move(loc)), name(std::move(name)), argSymbol(argName),
-        block(std::move(block)) {}
+  MainMethod(SourceLocation loc, SymbolTable::Symbol &sym,
+             SymbolTable::Symbol &argName, BlockPtr block)
+      : Method(NodeKind::MainMethod, std::move(loc)), symbol(sym),
+        argSymbol(argName), block(std::move(block)) {}
 
   void accept(Visitor *visitor) override { visitor->visitMainMethod(*this); }
   void acceptChildren(Visitor *visitor) override { block->accept(visitor); }
 
-  const std::string &getName() const override { return name; }
+  const std::string &getName() const override { return symbol.name; }
+  SymbolTable::Symbol &getSymbol() const { return symbol; }
   Type *getReturnType() const override {
     static PrimitiveType type({}, PrimitiveType::PrimType::Void);
     return &type;
   }
   const std::string &getArgName() const { return argSymbol.name; }
   SymbolTable::Symbol &getArgSymbol() const { return argSymbol; }
-  Block *getBlock() const { return block.get(); }
-  bool operator==(const MainMethod &o) const { return name == o.name; }
+  Block *getBlock() const override { return block; }
+  bool operator==(const MainMethod &o) const { return &symbol == &o.symbol; }
 };
-using MainMethodPtr = std::unique_ptr<MainMethod>;
+using MainMethodPtr = MainMethod *;
 
 class FieldList : public Node {
 public:
   std::vector<FieldPtr> fields;
 
   FieldList(std::vector<FieldPtr> fields)
-      : Node({}), fields(std::move(fields)) {}
+      : Node(NodeKind::FieldList, {}), fields(std::move(fields)) {}
   void accept(Visitor *visitor) override { visitor->visitFieldList(*this); }
   void acceptChildren(Visitor *visitor) override {
-    std::sort(fields.begin(), fields.end(), SortUniquePtrPred());
+    std::sort(fields.begin(), fields.end(), SortPtrPred());
     for (auto &e : fields) {
       visitor->visitField(*e);
     }
   }
 
-  void sortFields() {
-    std::stable_sort(fields.begin(), fields.end(), ast::SortUniquePtrPred());
-  }
-
   const std::vector<FieldPtr> &getFields() const { return fields; }
 };
 
@@ -717,19 +801,15 @@ public:
   std::vector<RegularMethodPtr> methods;
 
   MethodList(std::vector<RegularMethodPtr> methods)
-      : Node({}), methods(std::move(methods)) {}
+      : Node(NodeKind::MethodList, {}), methods(std::move(methods)) {}
   void accept(Visitor *visitor) override { visitor->visitMethodList(*this); }
   void acceptChildren(Visitor *visitor) override {
-    std::sort(methods.begin(), methods.end(), SortUniquePtrPred());
+    std::sort(methods.begin(), methods.end(), SortPtrPred());
     for (auto &e : methods) {
       visitor->visitRegularMethod(*e);
     }
   }
 
-  void sortMethods() {
-    std::stable_sort(methods.begin(), methods.end(), ast::SortUniquePtrPred());
-  }
-
   const std::vector<RegularMethodPtr> &getMethods() const { return methods; }
 };
 
@@ -738,12 +818,13 @@ public:
   std::vector<MainMethodPtr> mainMethods;
 
   MainMethodList(std::vector<MainMethodPtr> mainMethods)
-      : Node({}), mainMethods(std::move(mainMethods)) {}
+      : Node(NodeKind::MainMethodList, {}),
+        mainMethods(std::move(mainMethods)) {}
   void accept(Visitor *visitor) override {
     visitor->visitMainMethodList(*this);
   }
   void acceptChildren(Visitor *visitor) override {
-    std::sort(mainMethods.begin(), mainMethods.end(), SortUniquePtrPred());
+    std::sort(mainMethods.begin(), mainMethods.end(), SortPtrPred());
     for (auto &e : mainMethods) {
       visitor->visitMainMethod(*e);
     }
@@ -752,15 +833,21 @@ public:
 
 class Class : public Node {
   std::string name;
+  sem::ClassNames::Id classId;
   FieldList fields;
   MethodList methods;
   MainMethodList mainMethods;
+  // filled by addField/addMethod during semantic analysis
+  SymbolMap<Field> fieldTable;
+  SymbolMap<RegularMethod> methodTable;
 
 public:
   Class(SourceLocation loc, std::string name, FieldList fields,
         MethodList methods, MainMethodList mainMethods)
-      : Node(loc), name(std::move(name)), fields(std::move(fields)),
-        methods(std::move(methods)), mainMethods(std::move(mainMethods)) {}
+      : Node(NodeKind::Class, loc), name(std::move(name)),
+        classId(sem::ClassNames::intern(this->name)),
+        fields(std::move(fields)), methods(std::move(methods)),
+        mainMethods(std::move(mainMethods)) {}
 
   void accept(Visitor *visitor) override { visitor->visitClass(*this); }
 
@@ -770,32 +857,51 @@ public:
     visitor->visitMainMethodList(mainMethods);
   }
 
-  void sortMembers() {
-    fields.sortFields();
-    methods.sortMethods();
-  }
-
   const FieldList *getFields() const { return &fields; }
   const MethodList *getMethods() const { return &methods; }
   const MainMethodList *getMainMethods() const { return &mainMethods; }
+  FieldList *getFields() { return &fields; }
+  MethodList *getMethods() { return &methods; }
+  MainMethodList *getMainMethods() { return &mainMethods; }
 
   const std::string &getName() const { return name; }
+  sem::ClassNames::Id getClassId() const { return classId; }
+
+  // add a member to the lookup tables. If there already is one with the same
+  // name, returns that and leaves the table unchanged
+  Field *addField(Field *field) {
+    return fieldTable.insert(field->getSymbol(), field);
+  }
+  RegularMethod *addMethod(RegularMethod *method) {
+    return methodTable.insert(method->getSymbol(), method);
+  }
+  Field *findField(const SymbolTable::Symbol &sym) const {
+    return fieldTable.find(sym);
+  }
+  RegularMethod *findMethod(const SymbolTable::Symbol &sym) const {
+    return methodTable.find(sym);
+  }
 
   bool operator<(const Class &o) const { return name < o.name; }
   bool operator==(const Class &o) const { return name == o.name; }
 };
 
 class Program : public Node {
+  // owns all other nodes of the AST
+  Arena arena;
   std::vector<ClassPtr> classes;
+  // indexed by sem::ClassNames::Id, filled by addClass
+  std::vector<ClassPtr> classTable;
 
 public:
-  Program(SourceLocation loc, std::vector<ClassPtr> classes)
-      : Node(loc), classes(std::move(classes)) {}
+  Program(SourceLocation loc, std::vector<ClassPtr> classes, Arena arena)
+      : Node(NodeKind::Program, loc), arena(std::move(arena)),
+        classes(std::move(classes)) {}
 
   void accept(Visitor *visitor) override { visitor->visitProgram(*this); }
 
   void acceptChildren(Visitor *visitor) override {
-    std::sort(classes.begin(), classes.end(), SortUniquePtrPred());
+    std::sort(classes.begin(), classes.end(), SortPtrPred());
     for (auto &cp : classes) {
       visitor->visitClass(*cp);
     }
@@ -803,18 +909,26 @@ public:
 
   std::vector<ClassPtr> &getClasses() { return classes; }
 
-  ast::Class *findClassByName(const std::string &className) {
-    // implemented with binary search. TODO: maybe consider a set instead
-    auto pos =
-        std::lower_bound(classes.begin(), classes.end(), className,
-                         [](const ast::ClassPtr &cls, const std::string &str) {
-                           return cls->getName() < str;
-                         });
-    if ((pos == classes.end()) || (className < (*pos)->getName())) {
-      return nullptr;
+  // add a class to the lookup table. If there already is one with the same
+  // name, returns that and leaves the table unchanged
+  ast::Class *addClass(ast::Class *cls) {
+    auto id = cls->getClassId();
+    if (id >= classTable.size()) {
+      classTable.resize(id + 1, nullptr);
+    }
+    if (classTable[id]) {
+      return classTable[id];
     }
-    return pos->get();
+    classTable[id] = cls;
+    return nullptr;
+  }
+
+  ast::Class *findClass(sem::ClassNames::Id id) const {
+    return id < classTable.size() ? classTable[id] : nullptr;
   }
+
+  const Arena &getArena() const { return arena; }
+  Arena &getArena() { return arena; }
 };
 using ProgramPtr = std::unique_ptr<Program>;
 
@@ -829,7 +943,8 @@ class VariableDeclaration : public BlockStatement,
 public:
   VariableDeclaration(SourceLocation loc, TypePtr type,
                       SymbolTable::Symbol &sym, ExprPtr initializer)
-      : BlockStatement(std::move(loc)), type(std::move(type)), symbol(sym),
+      : BlockStatement(NodeKind::VariableDeclaration, std::move(loc)),
+        type(std::move(type)), symbol(sym),
         initializer(std::move(initializer)) {}
 
   void accept(Visitor *visitor) override {
@@ -839,13 +954,14 @@ public:
   void acceptChildren(Visitor *visitor) override {
     type->accept(visitor);
     if (initializer != nullptr)
-      initializer->accept(visitor);
+      visitor->visitExpression(*initializer);
   }
 
   SymbolTable::Symbol &getSymbol() const override { return symbol; }
   const std::string &getName() const { return symbol.name; }
-  Type *getType() const override { return type.get(); }
-  Expression *getInitializer() const { return initializer.get(); }
+  Type *getType() const override { return type; }
+  Expression *getInitializer() const { return initializer; }
+  void setInitializer(ExprPtr init) { initializer = init; }
 
   void setIndex(int i) { idx = i; }
   int getIndex() const { return idx; }
@@ -853,13 +969,14 @@ public:
 
 class PrimaryExpression : public Expression {
 protected:
-  PrimaryExpression(SourceLocation loc) : Expression(std::move(loc)) {}
+  PrimaryExpression(NodeKind kind, SourceLocation loc)
+      : Expression(kind, std::move(loc)) {}
 };
 
 class PrimaryRValueExpression : public PrimaryExpression {
 protected:
-  PrimaryRValueExpression(SourceLocation loc)
-      : PrimaryExpression(std::move(loc)) {}
+  PrimaryRValueExpression(NodeKind kind, SourceLocation loc)
+      : PrimaryExpression(kind, std::move(loc)) {}
 };
 
 class NewArrayExpression : public PrimaryRValueExpression {
@@ -868,7 +985,7 @@ class NewArrayExpression : public PrimaryRValueExpression {
 
 public:
   NewArrayExpression(SourceLocation loc, ArrayTypePtr arrayType, ExprPtr size)
-      : PrimaryRValueExpression(std::move(loc)),
+      : PrimaryRValueExpression(NodeKind::NewArrayExpression, std::move(loc)),
         arrayType(std::move(arrayType)), size(std::move(size)) {}
 
   void accept(Visitor *visitor) override {
@@ -878,24 +995,35 @@ public:
     arrayType->accept(visitor);
     size->accept(visitor);
   }
+  void expandChildren(Visitor *visitor,
+                      std::vector<Expression *> &stack) override {
+    arrayType->accept(visitor);
+    stack.push_back(size);
+  }
+  void expandChildSlots(std::vector<Expression **> &slots) override {
+    slots.push_back(&size);
+  }
 
-  ArrayType *getArrayType() const { return arrayType.get(); }
-  Expression *getSize() const { return size.get(); }
+  ArrayType *getArrayType() const { return arrayType; }
+  Expression *getSize() const { return size; }
 };
 
 class NewObjectExpression : public PrimaryRValueExpression {
   std::string name;
+  sem::ClassNames::Id classId;
   Class *classDef = nullptr;
 
 public:
   NewObjectExpression(SourceLocation loc, std::string name)
-      : PrimaryRValueExpression(std::move(loc)), name(std::move(name)) {}
+      : PrimaryRValueExpression(NodeKind::NewObjectExpression, std::move(loc)),
+        name(std::move(name)), classId(sem::ClassNames::intern(this->name)) {}
 
   void accept(Visitor *visitor) override {
     visitor->visitNewObjectExpression(*this);
   }
 
   const std::string &getName() const { return name; }
+  sem::ClassNames::Id getClassId() const { return classId; }
 
   void setDef(Class *def) { classDef = def; }
   Class *getDef() const { return classDef; }
@@ -903,8 +1031,8 @@ public:
 
 class LiteralExpression : public PrimaryRValueExpression {
 public:
-  LiteralExpression(SourceLocation loc)
-      : PrimaryRValueExpression(std::move(loc)) {}
+  LiteralExpression(NodeKind kind, SourceLocation loc)
+      : PrimaryRValueExpression(kind, std::move(loc)) {}
 };
 
 class IntLiteral : public LiteralExpression {
@@ -912,7 +1040,7 @@ class IntLiteral : public LiteralExpression {
 
 public:
   IntLiteral(SourceLocation loc, int32_t value)
-      : LiteralExpression(std::move(loc)), value(value) {}
+      : LiteralExpression(NodeKind::IntLiteral, std::move(loc)), value(value) {}
 
   void accept(Visitor *visitor) override { visitor->visitIntLiteral(*this); }
 
@@ -924,7 +1052,7 @@ class BoolLiteral : public LiteralExpression {
 
 public:
   BoolLiteral(SourceLocation loc, bool val)
-      : LiteralExpression(std::move(loc)), value(val) {}
+      : LiteralExpression(NodeKind::BoolLiteral, std::move(loc)), value(val) {}
 
   void accept(Visitor *visitor) override { visitor->visitBoolLiteral(*this); }
 
@@ -933,14 +1061,16 @@ public:
 
 class NullLiteral : public LiteralExpression {
 public:
-  NullLiteral(SourceLocation loc) : LiteralExpression(std::move(loc)) {}
+  NullLiteral(SourceLocation loc)
+      : LiteralExpression(NodeKind::NullLiteral, std::move(loc)) {}
 
   void accept(Visitor *visitor) override { visitor->visitNullLiteral(*this); }
 };
 
 class ThisLiteral : public LiteralExpression {
 public:
-  ThisLiteral(SourceLocation loc) : LiteralExpression(std::move(loc)) {}
+  ThisLiteral(SourceLocation loc)
+      : LiteralExpression(NodeKind::ThisLiteral, std::move(loc)) {}
 
   void accept(Visitor *visitor) override { visitor->visitThisLiteral(*this); }
 };
@@ -951,7 +1081,7 @@ class VarRef : public PrimaryExpression, public SymbolTable::Definition {
 
 public:
   VarRef(SourceLocation loc, SymbolTable::Symbol &sym)
-      : PrimaryExpression(std::move(loc)), symbol(sym) {}
+      : PrimaryExpression(NodeKind::VarRef, std::move(loc)), symbol(sym) {}
 
   static ast::DummyDefinition dummySystem;
 
@@ -967,17 +1097,18 @@ public:
 
 class MethodInvocation : public RValueExpression {
   ExprPtr left; // set to this if call from within function
-  std::string name;
+  SymbolTable::Symbol &symbol;
   // might be empty
   std::vector<ExprPtr> arguments;
   RegularMethod *methodDef;
   bool isSysout = false;
 
 public:
-  MethodInvocation(SourceLocation loc, ExprPtr lhs, std::string methodName,
-                   ExprList methodArgs)
-      : RValueExpression(std::move(loc)), left(std::move(lhs)),
-        name(std::move(methodName)), arguments(std::move(methodArgs)) {}
+  MethodInvocation(SourceLocation loc, ExprPtr lhs,
+                   SymbolTable::Symbol &methodName, ExprList methodArgs)
+      : RValueExpression(NodeKind::MethodInvocation, std::move(loc)),
+        left(std::move(lhs)), symbol(methodName),
+        arguments(std::move(methodArgs)) {}
 
   void accept(Visitor *visitor) override {
     visitor->visitMethodInvocation(*this);
@@ -991,6 +1122,18 @@ public:
       arg->accept(visitor);
     }
   }
+  void expandChildren(Visitor *, std::vector<Expression *> &stack) override {
+    stack.insert(stack.end(), arguments.rbegin(), arguments.rend());
+    if (left != nullptr)
+      stack.push_back(left);
+  }
+  void expandChildSlots(std::vector<Expression **> &slots) override {
+    for (auto &arg : arguments) {
+      slots.push_back(&arg);
+    }
+    if (left != nullptr)
+      slots.push_back(&left);
+  }
 
   const std::vector<ExprPtr> &getArguments() const { return arguments; }
 
@@ -1006,8 +1149,9 @@ public:
     return loc;
   }
 
-  Expression *getLeft() const { return left.get(); }
-  const std::string &getName() const { return name; }
+  Expression *getLeft() const { return left; }
+  const std::string &getName() const { return symbol.name; }
+  SymbolTable::Symbol &getSymbol() const { return symbol; }
 
   void setIsSysoutCall(bool val) { isSysout = val; }
   bool isSysoutCall() { return isSysout; }
@@ -1019,13 +1163,13 @@ public:
 class FieldAccess : public Expression {
   // left.field_name
   ExprPtr left; // set to this if call from within function
-  std::string name;
+  SymbolTable::Symbol &symbol;
   Field *fieldDef;
 
 public:
-  FieldAccess(SourceLocation loc, ExprPtr lhs, std::string memberName)
-      : Expression(std::move(loc)), left(std::move(lhs)),
-        name(std::move(memberName)) {}
+  FieldAccess(SourceLocation loc, ExprPtr lhs, SymbolTable::Symbol &memberName)
+      : Expression(NodeKind::FieldAccess, std::move(loc)), left(std::move(lhs)),
+        symbol(memberName) {}
 
   static ast::DummySystemOut dummySystemOut;
   static ast::DummySystemIn  dummySystemIn;
@@ -1035,9 +1179,18 @@ public:
     if (left != nullptr)
       left->accept(visitor);
   }
+  void expandChildren(Visitor *, std::vector<Expression *> &stack) override {
+    if (left != nullptr)
+      stack.push_back(left);
+  }
+  void expandChildSlots(std::vector<Expression **> &slots) override {
+    if (left != nullptr)
+      slots.push_back(&left);
+  }
 
-  Expression *getLeft() const { return left.get(); }
-  const std::string &getName() const { return name; }
+  Expression *getLeft() const { return left; }
+  const std::string &getName() const { return symbol.name; }
+  SymbolTable::Symbol &getSymbol() const { return symbol; }
 
   void setDef(Field *def) { fieldDef = def; }
   Field *getDef() const { return fieldDef; }
@@ -1049,17 +1202,25 @@ class ArrayAccess : public Expression {
 
 public:
   ArrayAccess(SourceLocation loc, ExprPtr lhs, ExprPtr index)
-      : Expression(std::move(loc)), array(std::move(lhs)),
-        index(std::move(index)) {}
+      : Expression(NodeKind::ArrayAccess, std::move(loc)),
+        array(std::move(lhs)), index(std::move(index)) {}
 
   void accept(Visitor *visitor) override { visitor->visitArrayAccess(*this); }
   void acceptChildren(Visitor *visitor) override {
     array->accept(visitor);
     index->accept(visitor);
   }
+  void expandChildren(Visitor *, std::vector<Expression *> &stack) override {
+    stack.push_back(index);
+    stack.push_back(array);
+  }
+  void expandChildSlots(std::vector<Expression **> &slots) override {
+    slots.push_back(&index);
+    slots.push_back(&array);
+  }
 
-  Expression *getArray() const { return array.get(); }
-  Expression *getIndex() const { return index.get(); }
+  Expression *getArray() const { return array; }
+  Expression *getIndex() const { return index; }
 };
 
 class BinaryExpression : public RValueExpression {
@@ -1090,8 +1251,8 @@ private:
 
 public:
   BinaryExpression(SourceLocation loc, ExprPtr lhs, ExprPtr rhs, Op op)
-      : RValueExpression(std::move(loc)), left(std::move(lhs)),
-        right(std::move(rhs)), operation(op) {}
+      : RValueExpression(NodeKind::BinaryExpression, std::move(loc)),
+        left(std::move(lhs)), right(std::move(rhs)), operation(op) {}
 
   static Op getOpForToken(Token::Type t) {
     switch (t) {
@@ -1136,9 +1297,17 @@ public:
     left->accept(visitor);
     right->accept(visitor);
   }
+  void expandChildren(Visitor *, std::vector<Expression *> &stack) override {
+    stack.push_back(right);
+    stack.push_back(left);
+  }
+  void expandChildSlots(std::vector<Expression **> &slots) override {
+    slots.push_back(&right);
+    slots.push_back(&left);
+  }
 
-  Expression *getLeft() const { return left.get(); }
-  Expression *getRight() const { return right.get(); }
+  Expression *getLeft() const { return left; }
+  Expression *getRight() const { return right; }
   Op getOperation() const { return operation; }
 };
 
@@ -1152,8 +1321,8 @@ private:
 
 public:
   UnaryExpression(SourceLocation loc, ExprPtr expression, Op operation)
-      : RValueExpression(std::move(loc)), expression(std::move(expression)),
-        operation(operation) {}
+      : RValueExpression(NodeKind::UnaryExpression, std::move(loc)),
+        expression(std::move(expression)), operation(operation) {}
 
   static Op getOpForToken(Token::Type t) {
     switch (t) {
@@ -1172,8 +1341,14 @@ public:
   void acceptChildren(Visitor *visitor) override {
     expression->accept(visitor);
   }
+  void expandChildren(Visitor *, std::vector<Expression *> &stack) override {
+    stack.push_back(expression);
+  }
+  void expandChildSlots(std::vector<Expression **> &slots) override {
+    slots.push_back(&expression);
+  }
 
-  Expression *getExpression() const { return expression.get(); }
+  Expression *getExpression() const { return expression; }
   Op getOperation() const { return operation; }
 };
 
@@ -1204,31 +1379,6 @@ public:
   DummySystemIn() : Field({}, nullptr, dummySymbol) {}
 };
 
-// ----
-
-template <typename St, typename... Args>
-StmtPtr make_SPtr(SourceLocation loc, Args &&... args) {
-  return StmtPtr{new St(loc, std::forward<Args>(args)...)};
-}
-// for copy/move constructor
-template <typename St> StmtPtr make_SPtr(const St &s) {
-  return StmtPtr{new St(s)};
-}
-
-template <typename Ex, typename... Args>
-ExprPtr make_EPtr(SourceLocation loc, Args &&... args) {
-  return ExprPtr{new Ex(loc, std::forward<Args>(args)...)};
-}
-// for copy/move constructor
-template <typename Ex> ExprPtr make_EPtr(const Ex &e) {
-  return ExprPtr{new Ex(e)};
-}
-
-template <typename T, typename... Args>
-std::unique_ptr<T> make_Ptr(SourceLocation loc, Args &&... args) {
-  return std::unique_ptr<T>{new T(loc, std::forward<Args>(args)...)};
-}
-
 } // namespace ast
 
 #endif // AST_H
@@ -0,0 +1,39 @@
+#include "call_graph_visitor.hpp"
+
+void CallGraphVisitor::addMethod(ast::Method *method) {
+  if (reachable.insert(method).second) {
+    worklist.push_back(method);
+  }
+}
+
+void CallGraphVisitor::visitProgram(ast::Program &program) {
+  for (auto *cls : program.getClasses()) {
+    for (auto *method : cls->getMainMethods()->mainMethods) {
+      addMethod(method);
+    }
+  }
+  while (!worklist.empty()) {
+    auto *method = worklist.back();
+    worklist.pop_back();
+    // only the body can contain calls
+    visitBlock(*method->getBlock());
+  }
+}
+
+void CallGraphVisitor::visitExpression(ast::Expression &expr) {
+  // with an explicit stack like SemanticVisitor::visitExpression, the order
+  // of the visits doesn't matter here
+  ast::Expression *root = &expr;
+  slotStack.push_back(&root);
+  while (!slotStack.empty()) {
+    auto *e = *slotStack.back();
+    slotStack.pop_back();
+    if (e->getKind() == ast::NodeKind::MethodInvocation) {
+      auto *call = static_cast<ast::MethodInvocation *>(e);
+      if (!call->isSysoutCall()) {
+        addMethod(call->getDef());
+      }
+    }
+    e->expandChildSlots(slotStack);
+  }
+}
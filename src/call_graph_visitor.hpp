@@ -0,0 +1,33 @@
+#ifndef CALL_GRAPH_VISITOR_H
+#define CALL_GRAPH_VISITOR_H
+
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+#include "static_visitor.hpp"
+
+// Finds the methods which can be called when running the program, starting
+// from its main method. Runs on an attributed AST, calls are resolved through
+// MethodInvocation::getDef since there is no inheritance. Visits every
+// reachable method body, so it dispatches statically.
+class CallGraphVisitor : public ast::StaticVisitor<CallGraphVisitor> {
+  std::unordered_set<const ast::Method *> reachable;
+  // reachable methods whose bodies are still to visit
+  std::vector<ast::Method *> worklist;
+  // subexpressions still to visit, see visitExpression
+  std::vector<ast::Expression **> slotStack;
+
+  void addMethod(ast::Method *method);
+
+public:
+  void visitProgram(ast::Program &program);
+  void visitExpression(ast::Expression &expr);
+
+  bool isReachable(const ast::Method &method) const {
+    return reachable.count(&method) > 0;
+  }
+  size_t getNumReachable() const { return reachable.size(); }
+};
+
+#endif // CALL_GRAPH_VISITOR_H
@@ -30,6 +30,7 @@
 
 #include <fcntl.h>
 
+#include "constant_folder.hpp"
 #include "dotvisitor.hpp"
 #include "error.hpp"
 #include "firm_visitor.hpp"
@@ -54,7 +55,8 @@ int Compiler::echoFile() {
 }
 
 int Compiler::lexTest() {
-  Lexer lexer{inputFile};
+  SymbolTable::StringTable strTbl;
+  Lexer lexer{inputFile, strTbl};
   try {
     while (true) {
       Token t = lexer.nextToken();
@@ -72,7 +74,8 @@ int Compiler::lexTest() {
 }
 
 int Compiler::lexFuzz() {
-  Lexer lexer{inputFile};
+  SymbolTable::StringTable strTbl;
+  Lexer lexer{inputFile, strTbl};
   try {
     while (lexer.nextToken().type != Token::Type::Eof) {
       // do nothing
@@ -173,22 +176,39 @@ int Compiler::attrAstDot() {
   }
 }
 
+// for --opt-stats. Only the count is known: the skipped methods never get a
+// graph, so there is nothing to time them against.
+static void printSkippedMethods(const FirmVisitor &firmVisitor) {
+  std::cout << "Skipped " << firmVisitor.getNumSkippedMethods()
+            << " unreachable methods (no graphs built, time saved not measured)"
+            << std::endl;
+}
+
 int Compiler::compile() {
   SymbolTable::StringTable strTbl;
   Parser parser{inputFile, strTbl};
   try {
     auto ast = parser.parseProgram();
     analyzeAstSemantic(ast.get(), parser.getLexer());
+    if (options.optimize) {
+      ConstantFolder folder{*ast};
+      ast->accept(&folder);
+    }
     FirmVisitor firmVisitor{options.printFirmGraph};
     ast->accept(&firmVisitor);
+    if (options.printOptStats) {
+      printSkippedMethods(firmVisitor);
+    }
 
     for (auto g : firmVisitor.getFirmGraphs()) {
       lower_highlevel_graph(g);
     }
 
-    if (options.optimize) {
-      Optimizer opt(firmVisitor.getFirmGraphs(), options.printFirmGraph, !options.noVerify);
-      if (!opt.run()) {
+    Optimizer opt(options.optimizationLevel, options.enabledPasses,
+                  options.disabledPasses, options.printFirmGraph,
+                  !options.noVerify, options.printOptStats);
+    if (opt.hasPasses()) {
+      if (!opt.run(firmVisitor.getFirmGraphs())) {
         return EXIT_FAILURE;
       }
     }
@@ -203,27 +223,73 @@ int Compiler::compile() {
   }
 }
 
-bool Compiler::lowerFirmGraphs(std::vector<ir_graph*> &graphs, bool printGraphs, bool verifyGraphs, bool outputAssembly, const std::string &outFileName) {
-  int graphErrors = 0;
-  for (auto g : graphs) {
-    // needs to happen in this order to correctly remove all bads that we insert ourselves
-    remove_bads(g);
-    remove_unreachable_code(g);
-    remove_bads(g);
+// removes the Bads we inserted ourselves, returns false if the graph doesn't
+// verify afterwards
+static bool finishGraph(ir_graph *g, bool printGraphs, bool verifyGraphs) {
+  // needs to happen in this order to correctly remove all bads that we insert ourselves
+  remove_bads(g);
+  remove_unreachable_code(g);
+  remove_bads(g);
 
-    if (printGraphs) {
-      dump_ir_graph(g, "lowered");
-    }
-    if (verifyGraphs) {
-      if (irg_verify(g) == 0)
-        graphErrors++;
-    }
+  if (printGraphs) {
+    dump_ir_graph(g, "lowered");
   }
-  if (graphErrors)
-    return false;
+  if (verifyGraphs) {
+    if (irg_verify(g) == 0)
+      return false;
+  }
+  return true;
+}
 
+// The optimizations on the generated code, in order. Their statistics add up
+// over several runs, so the functions can also be optimized one at a time.
+class AsmOptimizations {
+  Asm::Program *program;
+  AsmJumpOptimizer jumpOpt;
+  AsmSimpleOptimizer simpleOpt;
+  AsmMovOptimizer movOpt;
+  AsmStackOptimizer stackOpt;
+  AsmArrayOptimizer arrayOpt;
+  AsmAliasOptimizer aliasOpt;
+  AsmArithOptimizer arithOpt;
+
+public:
+  AsmOptimizations(Asm::Program *program)
+      : program(program), jumpOpt(program), simpleOpt(program),
+        movOpt(program), stackOpt(program), arrayOpt(program),
+        aliasOpt(program), arithOpt(program) {}
+
+  // also flattens the functions
+  void run() {
+    jumpOpt.run();
+    simpleOpt.run();
+
+    program->flattenFunctions(); // <---------------------
+
+    movOpt.run();
+    stackOpt.run();
+    arrayOpt.run();
+    movOpt.run(); // MovOptimizer again
+    aliasOpt.run();
+    arithOpt.run();
+  }
+
+  void printOptimizations() {
+    jumpOpt.printOptimizations();
+    simpleOpt.printOptimizations();
+    stackOpt.printOptimizations();
+    arrayOpt.printOptimizations();
+    movOpt.printOptimizations();
+    aliasOpt.printOptimizations();
+    arithOpt.printOptimizations();
+  }
+};
+
+// the assembly goes to <outFileName>.s or to a temporary file
+static FILE *openAssemblyFile(bool outputAssembly,
+                              const std::string &outFileName,
+                              std::string &assemblyName) {
   FILE *f = nullptr;
-  std::string assemblyName;
   if (outputAssembly) {
     assemblyName = outFileName + ".s";
     f = fopen(assemblyName.c_str(), "w");
@@ -231,6 +297,32 @@ bool Compiler::lowerFirmGraphs(std::vector<ir_graph*> &graphs, bool printGraphs,
     f = tmpfile();
     assemblyName = "/proc/self/fd/" + std::to_string(fileno(f));
   }
+  return f;
+}
+
+static void linkAssembly(FILE *f, const std::string &assemblyName,
+                         const std::string &outFileName) {
+  int res = 0;
+  // XXX -g and -gstabs+ for debugging so we can step through asm instructions
+  //res |= system(("gcc -g -gstabs+ -static -x assembler " + assemblyName + " -o " + outFileName + " -L" LIBSEARCHDIR " -lruntime").c_str());
+  res |= system(("gcc -static -x assembler " + assemblyName + " -o " + outFileName + " -L" LIBSEARCHDIR " -lruntime").c_str());
+  fclose(f);
+  if (res) {
+    throw std::runtime_error("Error while linking binary");
+  }
+}
+
+bool Compiler::lowerFirmGraphs(std::vector<ir_graph*> &graphs, bool printGraphs, bool verifyGraphs, bool outputAssembly, const std::string &outFileName) {
+  int graphErrors = 0;
+  for (auto g : graphs) {
+    if (!finishGraph(g, printGraphs, verifyGraphs))
+      graphErrors++;
+  }
+  if (graphErrors)
+    return false;
+
+  std::string assemblyName;
+  FILE *f = openAssemblyFile(outputAssembly, outFileName, assemblyName);
   if (options.compileFirm) {
     be_parse_arg("isa=amd64");
     be_main(f, "test.java");
@@ -244,38 +336,9 @@ bool Compiler::lowerFirmGraphs(std::vector<ir_graph*> &graphs, bool printGraphs,
 
     // Run optimizations on ASM code
     if (options.optimize) {
-      AsmJumpOptimizer opt1(program);
-      opt1.run();
-      opt1.printOptimizations();
-
-      AsmSimpleOptimizer opt2(program);
-      opt2.run();
-      opt2.printOptimizations();
-
-      program->flattenFunctions(); // <---------------------
-
-      AsmMovOptimizer opt3(program);
-      opt3.run();
-
-      AsmStackOptimizer opt4(program);
-      opt4.run();
-      opt4.printOptimizations();
-
-      AsmArrayOptimizer opt5(program);
-      opt5.run();
-      opt5.printOptimizations();
-
-      opt3.run(); // MovOptimizer again
-      opt3.printOptimizations();
-
-      AsmAliasOptimizer opt8(program);
-      opt8.run();
-      opt8.printOptimizations();
-
-      AsmArithOptimizer opt7(program);
-      opt7.run();
-      opt7.printOptimizations();
-
+      AsmOptimizations optimizations(program);
+      optimizations.run();
+      optimizations.printOptimizations();
     } else {
       program->flattenFunctions();
     }
@@ -288,18 +351,97 @@ bool Compiler::lowerFirmGraphs(std::vector<ir_graph*> &graphs, bool printGraphs,
     outputFile << *program << std::endl;
   }
 
-  int res = 0;
-  // XXX -g and -gstabs+ for debugging so we can step through asm instructions
-  //res |= system(("gcc -g -gstabs+ -static -x assembler " + assemblyName + " -o " + outFileName + " -L" LIBSEARCHDIR " -lruntime").c_str());
-  res |= system(("gcc -static -x assembler " + assemblyName + " -o " + outFileName + " -L" LIBSEARCHDIR " -lruntime").c_str());
-  fclose(f);
-  if (res) {
-    throw std::runtime_error("Error while linking binary");
-  }
-
+  linkAssembly(f, assemblyName, outFileName);
   return true;
 }
 
+// Like compile, but each method goes through Firm construction, the
+// optimizations, code generation and output before the next one is built,
+// and its graph and code are freed afterwards. Only the AST, the types and
+// the entities stay alive for the whole program.
+int Compiler::compileStreaming() {
+  SymbolTable::StringTable strTbl;
+  Parser parser{inputFile, strTbl};
+  try {
+    auto ast = parser.parseProgram();
+    analyzeAstSemantic(ast.get(), parser.getLexer());
+    if (options.optimize) {
+      ConstantFolder folder{*ast};
+      ast->accept(&folder);
+    }
+    FirmVisitor firmVisitor{options.printFirmGraph};
+    firmVisitor.declareProgram(*ast);
+
+    std::string outputName = options.outputFileName.empty() ? "a.out" : options.outputFileName;
+    std::string assemblyName;
+    FILE *f = openAssemblyFile(options.outputAssembly, outputName, assemblyName);
+    std::ofstream outputFile(assemblyName);
+    if (!outputFile.is_open()) {
+      fclose(f);
+      throw std::runtime_error("could not open file '" + assemblyName + '\'');
+    }
+    Asm::AsmWriter writer(outputFile);
+    writer.writeTextSection();
+
+    // only ever holds the function currently compiled
+    Asm::Program program;
+    AsmOptimizations optimizations(&program);
+    bool verifyGraphs = !options.noVerify;
+    // program passes are left out, unreachable methods are skipped anyway
+    Optimizer optimizer(options.optimizationLevel, options.enabledPasses,
+                        options.disabledPasses, options.printFirmGraph,
+                        verifyGraphs, options.printOptStats);
+    for (auto *klass : ast->getClasses()) {
+      std::vector<ast::Method *> methods;
+      for (auto *method : klass->getMethods()->methods) {
+        methods.push_back(method);
+      }
+      for (auto *method : klass->getMainMethods()->mainMethods) {
+        methods.push_back(method);
+      }
+
+      for (auto *method : methods) {
+        ir_graph *graph = firmVisitor.buildGraph(*klass, *method);
+        if (graph == nullptr) {
+          continue; // unreachable
+        }
+        lower_highlevel_graph(graph);
+        if ((optimizer.hasPasses() && !optimizer.optimizeGraph(graph)) ||
+            !finishGraph(graph, options.printFirmGraph, verifyGraphs)) {
+          fclose(f);
+          return EXIT_FAILURE;
+        }
+
+        program.addFunction(AsmPass::generateFunction(graph, options.optimize));
+        if (options.optimize) {
+          optimizations.run();
+        } else {
+          program.flattenFunctions();
+        }
+        program.functions.back().write(writer);
+        program.functions.clear();
+        free_ir_graph(graph);
+      }
+    }
+    outputFile << std::endl;
+    outputFile.close();
+
+    if (options.printOptStats) {
+      printSkippedMethods(firmVisitor);
+      optimizer.printStatistics(std::cout);
+    }
+    if (options.optimize) {
+      optimizations.printOptimizations();
+    }
+
+    linkAssembly(f, assemblyName, outputName);
+    return EXIT_SUCCESS;
+  } catch (CompilerError &e) {
+    e.writeErrorMessage(std::cerr);
+    return EXIT_FAILURE;
+  }
+}
+
 void Compiler::analyzeAstSemantic(ast::Program *astRoot, Lexer &lexer) {
   SemanticVisitor semantic_visitor(lexer);
   astRoot->accept(&semantic_visitor);
@@ -322,6 +464,25 @@ void Compiler::checkOptions() {
         "Cannot have Options --echo, --lextext, --lexfuzz, "
         "--parsertest, --parserfuzz, --print-ast, --dot-ast, "
         "--check, --fuzz-check or --dot-attr-ast simultaneously");
+  if (options.streaming && options.compileFirm)
+    throw ArgumentError("Cannot use --stream with --compile-firm, the firm "
+                        "backend needs all graphs at once");
+  if (options.optimizationLevel < 0 ||
+      options.optimizationLevel > Optimizer::maxLevel)
+    throw ArgumentError("Optimization level must be between 0 and " +
+                        std::to_string(Optimizer::maxLevel));
+  for (auto *names : {&options.enabledPasses, &options.disabledPasses}) {
+    for (auto &name : *names) {
+      if (Optimizer::findPass(name) == nullptr) {
+        std::string known;
+        for (auto &pass : Optimizer::getPasses()) {
+          known += known.empty() ? pass.name : std::string(", ") + pass.name;
+        }
+        throw ArgumentError("Unknown optimization pass '" + name +
+                            "', known passes are: " + known);
+      }
+    }
+  }
 }
 
 int Compiler::run() {
@@ -345,6 +506,8 @@ int Compiler::run() {
     return fuzzSemantic();
   } else if (options.dotAttrAst) {
     return attrAstDot();
+  } else if (options.streaming) {
+    return compileStreaming();
   } else {
     return compile();
   }
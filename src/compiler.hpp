@@ -29,6 +29,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <libfirm/firm.h>
 
 #include "ast.hpp"
@@ -55,8 +56,15 @@ struct CompilerOptions {
   bool compileFirm = false;
   bool noVerify = false;
   bool outputAssembly = false;
+  bool streaming = false;
 
   bool optimize = true;
+  // the -O level, optimize is false for level 0
+  int optimizationLevel = 2;
+  // from -fpass=<name> and -fno-pass=<name>, see Optimizer
+  std::vector<std::string> enabledPasses;
+  std::vector<std::string> disabledPasses;
+  bool printOptStats = false;
   // ...
 };
 
@@ -78,6 +86,7 @@ class Compiler {
   int fuzzSemantic();
   int attrAstDot();
   int compile();
+  int compileStreaming();
   bool lowerFirmGraphs(std::vector<ir_graph*> &graphs, bool printGraphs, bool verifyGraphs, bool outputAssembly, const std::string &outFileName = "a.out");
 
   void checkOptions();
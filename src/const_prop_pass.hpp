@@ -48,13 +48,6 @@ std::string tarvalToStr(ir_tarval *t) {
     }
 }
 
-void exchangeWithLink(ir_node *oldNode, ir_node* newNode) {
-  // might be needed by later substitutions (e.g. Proj below)
-  // TODO: drop this function once we walk backwards during subst phase
-  set_irn_link(newNode, get_irn_link(oldNode));
-  exchange(oldNode, newNode);
-}
-
 class ConstPropPass : public FunctionPass<ConstPropPass, ir_tarval>
 {
 private:
@@ -232,7 +225,7 @@ public:
     }
 
     if (is_loop_breaker || !irn_visited(irn))
-      substituteNode(irn);
+      changed |= substituteNode(irn);
 
     mark_irn_visited(irn);
   }
@@ -0,0 +1,248 @@
+#include "constant_folder.hpp"
+
+// int arithmetic wraps around like in Java, so it's done on unsigned values
+static int32_t wrapAdd(int32_t l, int32_t r) {
+  return static_cast<int32_t>(static_cast<uint32_t>(l) +
+                              static_cast<uint32_t>(r));
+}
+static int32_t wrapSub(int32_t l, int32_t r) {
+  return static_cast<int32_t>(static_cast<uint32_t>(l) -
+                              static_cast<uint32_t>(r));
+}
+static int32_t wrapMul(int32_t l, int32_t r) {
+  return static_cast<int32_t>(static_cast<uint32_t>(l) *
+                              static_cast<uint32_t>(r));
+}
+
+void ConstantFolder::visitBlock(ast::Block &block) {
+  auto &statements = block.getStatements();
+  size_t numLive = 0;
+  for (size_t i = 0; i < statements.size(); ++i) {
+    auto *stmt = foldStatement(statements[i]);
+    if (stmt == nullptr) {
+      continue;
+    }
+    statements[numLive++] = stmt;
+    // a removed branch may leave a return behind, the rest is dead then
+    if (stmt->cfb == sem::ControlFlowBehavior::Return) {
+      break;
+    }
+  }
+  statements.resize(numLive);
+
+  block.cfb = numLive > 0 ? statements.back()->cfb
+                          : sem::ControlFlowBehavior::MayContinue;
+  replacement = &block;
+}
+
+void ConstantFolder::visitVariableDeclaration(ast::VariableDeclaration &decl) {
+  if (decl.getInitializer() != nullptr) {
+    decl.setInitializer(foldExpression(decl.getInitializer()));
+  }
+  replacement = &decl;
+}
+
+void ConstantFolder::visitExpressionStatement(ast::ExpressionStatement &stmt) {
+  auto *expr = foldExpression(stmt.getExpression());
+  stmt.setExpression(expr);
+  // literals have no side effects
+  if (dynamic_cast<ast::LiteralExpression *>(expr)) {
+    replacement = nullptr;
+  } else {
+    replacement = &stmt;
+  }
+}
+
+void ConstantFolder::visitIfStatement(ast::IfStatement &stmt) {
+  stmt.setCondition(foldExpression(stmt.getCondition()));
+  if (auto *cond = dynamic_cast<ast::BoolLiteral *>(stmt.getCondition())) {
+    replacement = foldStatement(cond->getValue() ? stmt.getThenStatement()
+                                                 : stmt.getElseStatement());
+    return;
+  }
+
+  stmt.setThenStatement(foldStatement(stmt.getThenStatement()));
+  stmt.setElseStatement(foldStatement(stmt.getElseStatement()));
+  auto thenCFB = stmt.getThenStatement()
+                     ? stmt.getThenStatement()->cfb
+                     : sem::ControlFlowBehavior::MayContinue;
+  auto elseCFB = stmt.getElseStatement()
+                     ? stmt.getElseStatement()->cfb
+                     : sem::ControlFlowBehavior::MayContinue;
+  stmt.cfb = sem::combineCFB(thenCFB, elseCFB);
+  replacement = &stmt;
+}
+
+void ConstantFolder::visitWhileStatement(ast::WhileStatement &stmt) {
+  stmt.setCondition(foldExpression(stmt.getCondition()));
+  auto *cond = dynamic_cast<ast::BoolLiteral *>(stmt.getCondition());
+  if (cond && !cond->getValue()) {
+    replacement = nullptr;
+    return;
+  }
+
+  stmt.setStatement(foldStatement(stmt.getStatement()));
+  replacement = &stmt;
+}
+
+void ConstantFolder::visitReturnStatement(ast::ReturnStatement &stmt) {
+  if (stmt.getExpression() != nullptr) {
+    stmt.setExpression(foldExpression(stmt.getExpression()));
+  }
+  replacement = &stmt;
+}
+
+ast::BlockStatement *ConstantFolder::foldStatement(ast::BlockStatement *stmt) {
+  if (stmt == nullptr) {
+    return nullptr;
+  }
+  stmt->accept(this);
+  return replacement;
+}
+
+ast::Expression *ConstantFolder::foldExpression(ast::Expression *expr) {
+  // Folds bottom up with an explicit stack, like
+  // SemanticVisitor::visitExpression. A nullptr marks that the children of
+  // the slot below it have been folded.
+  ast::Expression *root = expr;
+  slotStack.push_back(&root);
+  while (!slotStack.empty()) {
+    auto **slot = slotStack.back();
+    if (slot == nullptr) {
+      slotStack.pop_back();
+      slot = slotStack.back();
+      slotStack.pop_back();
+      *slot = foldNode(*slot);
+    } else {
+      slotStack.push_back(nullptr);
+      (*slot)->expandChildSlots(slotStack);
+    }
+  }
+  return root;
+}
+
+ast::Expression *ConstantFolder::foldNode(ast::Expression *expr) {
+  if (auto *binary = dynamic_cast<ast::BinaryExpression *>(expr)) {
+    return foldBinary(*binary);
+  }
+  if (auto *unary = dynamic_cast<ast::UnaryExpression *>(expr)) {
+    return foldUnary(*unary);
+  }
+  return expr;
+}
+
+ast::Expression *ConstantFolder::foldBinary(ast::BinaryExpression &expr) {
+  using Op = ast::BinaryExpression::Op;
+  auto *left = expr.getLeft();
+  auto *right = expr.getRight();
+  auto *leftBool = dynamic_cast<ast::BoolLiteral *>(left);
+  auto *rightBool = dynamic_cast<ast::BoolLiteral *>(right);
+
+  switch (expr.getOperation()) {
+  case Op::And:
+    // the right side is only evaluated if the left one is true
+    if (leftBool) {
+      return leftBool->getValue() ? right : left;
+    }
+    if (rightBool && rightBool->getValue()) {
+      return left;
+    }
+    return &expr;
+  case Op::Or:
+    if (leftBool) {
+      return leftBool->getValue() ? left : right;
+    }
+    if (rightBool && !rightBool->getValue()) {
+      return left;
+    }
+    return &expr;
+  case Op::Equals:
+    if (leftBool && rightBool) {
+      return makeBool(expr, leftBool->getValue() == rightBool->getValue());
+    }
+    break;
+  case Op::NotEquals:
+    if (leftBool && rightBool) {
+      return makeBool(expr, leftBool->getValue() != rightBool->getValue());
+    }
+    break;
+  default:
+    break;
+  }
+
+  auto *leftInt = dynamic_cast<ast::IntLiteral *>(left);
+  auto *rightInt = dynamic_cast<ast::IntLiteral *>(right);
+  if (!leftInt || !rightInt) {
+    return &expr;
+  }
+  int32_t l = leftInt->getValue();
+  int32_t r = rightInt->getValue();
+
+  switch (expr.getOperation()) {
+  case Op::Equals:
+    return makeBool(expr, l == r);
+  case Op::NotEquals:
+    return makeBool(expr, l != r);
+  case Op::Less:
+    return makeBool(expr, l < r);
+  case Op::LessEquals:
+    return makeBool(expr, l <= r);
+  case Op::Greater:
+    return makeBool(expr, l > r);
+  case Op::GreaterEquals:
+    return makeBool(expr, l >= r);
+  case Op::Plus:
+    return makeInt(expr, wrapAdd(l, r));
+  case Op::Minus:
+    return makeInt(expr, wrapSub(l, r));
+  case Op::Mul:
+    return makeInt(expr, wrapMul(l, r));
+  case Op::Div:
+    // division by zero throws at run time
+    if (r == 0) {
+      return &expr;
+    }
+    // INT_MIN / -1 overflows to INT_MIN
+    return makeInt(expr, r == -1 ? wrapSub(0, l) : l / r);
+  case Op::Mod:
+    if (r == 0) {
+      return &expr;
+    }
+    return makeInt(expr, r == -1 ? 0 : l % r);
+  default:
+    return &expr;
+  }
+}
+
+ast::Expression *ConstantFolder::foldUnary(ast::UnaryExpression &expr) {
+  auto *operand = expr.getExpression();
+  switch (expr.getOperation()) {
+  case ast::UnaryExpression::Op::Neg:
+    if (auto *lit = dynamic_cast<ast::IntLiteral *>(operand)) {
+      return makeInt(expr, wrapSub(0, lit->getValue()));
+    }
+    break;
+  case ast::UnaryExpression::Op::Not:
+    if (auto *lit = dynamic_cast<ast::BoolLiteral *>(operand)) {
+      return makeBool(expr, !lit->getValue());
+    }
+    break;
+  default:
+    break;
+  }
+  return &expr;
+}
+
+ast::Expression *ConstantFolder::makeInt(const ast::Expression &expr,
+                                         int32_t value) {
+  auto *lit = arena.create<ast::IntLiteral>(expr.getLoc(), value);
+  lit->targetType.setInt();
+  return lit;
+}
+
+ast::Expression *ConstantFolder::makeBool(const ast::Expression &expr,
+                                          bool value) {
+  auto *lit = arena.create<ast::BoolLiteral>(expr.getLoc(), value);
+  lit->targetType.setBool();
+  return lit;
+}
@@ -0,0 +1,45 @@
+#ifndef CONSTANT_FOLDER_H
+#define CONSTANT_FOLDER_H
+
+#include "ast.hpp"
+
+// Folds expressions on int and boolean literals and removes if and while
+// statements whose condition is constant, so FirmVisitor never builds blocks
+// for dead code. Runs on a program that passed the SemanticVisitor.
+class ConstantFolder : public ast::Visitor {
+  Arena &arena;
+  // what the last visited statement is to be replaced with, nullptr if it
+  // is to be removed
+  ast::BlockStatement *replacement = nullptr;
+  // expression slots still to fold, see foldExpression
+  std::vector<ast::Expression **> slotStack;
+
+public:
+  ConstantFolder(ast::Program &program) : arena(program.getArena()) {}
+
+  void visitBlock(ast::Block &block) override;
+  void visitVariableDeclaration(ast::VariableDeclaration &decl) override;
+  void visitExpressionStatement(ast::ExpressionStatement &stmt) override;
+  void visitIfStatement(ast::IfStatement &stmt) override;
+  void visitWhileStatement(ast::WhileStatement &stmt) override;
+  void visitReturnStatement(ast::ReturnStatement &stmt) override;
+
+  virtual ~ConstantFolder() {}
+
+private:
+  ast::BlockStatement *foldStatement(ast::BlockStatement *stmt);
+  ast::Statement *foldStatement(ast::Statement *stmt) {
+    // statements are only ever replaced by their own substatements
+    return static_cast<ast::Statement *>(
+        foldStatement(static_cast<ast::BlockStatement *>(stmt)));
+  }
+  ast::Expression *foldExpression(ast::Expression *expr);
+  ast::Expression *foldNode(ast::Expression *expr);
+  ast::Expression *foldBinary(ast::BinaryExpression &expr);
+  ast::Expression *foldUnary(ast::UnaryExpression &expr);
+
+  ast::Expression *makeInt(const ast::Expression &expr, int32_t value);
+  ast::Expression *makeBool(const ast::Expression &expr, bool value);
+};
+
+#endif // CONSTANT_FOLDER_H
@@ -8,12 +8,12 @@ void DotVisitor::visitProgram(ast::Program &program) {
   s << "rankdir=LR\n"; // TODO worth considering
   // first add all class node names:
   for (auto &klass : program.getClasses()) {
-    nodeNames[klass.get()] = newNodeName();
+    nodeNames[klass] = newNodeName();
     for (auto &f : klass->getFields()->fields) {
-      nodeNames[f.get()] = newNodeName();
+      nodeNames[f] = newNodeName();
     }
     for (auto &m : klass->getMethods()->methods) {
-      nodeNames[m.get()] = newNodeName();
+      nodeNames[m] = newNodeName();
     }
   }
   program.acceptChildren(this);
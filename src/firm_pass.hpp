@@ -34,11 +34,21 @@
 #include <cstdlib>
 #include <iostream>
 
+// exchanges oldNode with newNode and keeps the pass data of oldNode
+inline void exchangeWithLink(ir_node *oldNode, ir_node* newNode) {
+  // might be needed by later substitutions (e.g. Proj below)
+  // TODO: drop this function once we walk backwards during subst phase
+  set_irn_link(newNode, get_irn_link(oldNode));
+  exchange(oldNode, newNode);
+}
+
 template <typename T, typename AttrT = void>
 class FunctionPass {
 protected:
   ir_graph *graph;
   std::queue<ir_node*> worklist;
+  // set by passes which modified the graph, returned by run
+  bool changed = false;
   T *sub() { return static_cast<T*>(this); }
 public:
   FunctionPass(ir_graph *firmgraph) : graph(firmgraph) {
@@ -87,7 +97,8 @@ private:
   }
 
 public:
-  void run() {
+  // returns whether the graph was changed
+  bool run() {
     ir_reserve_resources(graph, IR_RESOURCE_IRN_LINK);
 
     sub()->before();
@@ -104,8 +115,14 @@ public:
     sub()->after();
 
     ir_free_resources(graph, IR_RESOURCE_IRN_LINK);
+    return changed;
   }
 
+  // number of transformations done, added up for all graphs for --opt-stats
+  unsigned getNumChanges() const { return 0; }
+  // prints the sum of getNumChanges of all runs for --opt-stats
+  static void printStats(std::ostream &, unsigned) {}
+
 protected:
   void before() {};
   void initWorkQueue() { initNodesTopological(); }
@@ -400,6 +417,8 @@ class ProgramPass {
 protected:
   std::queue<ir_graph*> worklist;
   std::vector<ir_graph *> &allGraphs;
+  // set by passes which modified the program, returned by run
+  bool changed = false;
   T *sub() { return static_cast<T*>(this); }
 public:
   ProgramPass(std::vector<ir_graph *> &graphs) : allGraphs(graphs) {}
@@ -410,7 +429,10 @@ public:
     }
   }
 
-  void run() {
+  // returns whether the program was changed. A pass may be run several times,
+  // it keeps its state in between.
+  bool run() {
+    changed = false;
     sub()->before();
 
     sub()->initWorkList();
@@ -422,8 +444,14 @@ public:
     }
 
     sub()->after();
+    return changed;
   }
 
+  // number of transformations done in all runs so far, for --opt-stats
+  unsigned getNumChanges() const { return 0; }
+  // prints getNumChanges after the last run for --opt-stats
+  static void printStats(std::ostream &, unsigned) {}
+
   void enqueue(ir_graph *graph) {
     assert(graph);
     worklist.push(graph);
@@ -152,8 +152,20 @@ FirmVisitor::FirmVisitor(bool print){
 }
 
 void FirmVisitor::visitProgram(ast::Program &program) {
+  declareProgram(program);
+
+  for (auto &klass : program.getClasses()) {
+    this->currentClass = klass;
+    klass->acceptChildren(this);
+  }
+
+  assert(nodeStack.size() == 0);
+}
+
+void FirmVisitor::declareProgram(ast::Program &program) {
   this->currentProgram = &program;
   auto &classes = program.getClasses();
+  callGraph.visitProgram(program);
 
   // First, collect all class types
   for (auto &klass : classes) {
@@ -162,13 +174,19 @@ void FirmVisitor::visitProgram(ast::Program &program) {
   for (auto &klass : classes) {
     klass->accept(this); // Will not recurse into children
   }
+}
 
-  for (auto &klass : classes) {
-    this->currentClass = klass.get();
-    klass->acceptChildren(this);
-  }
-
+ir_graph *FirmVisitor::buildGraph(ast::Class &klass, ast::Method &method) {
+  this->currentClass = &klass;
+  size_t numGraphs = firmGraphs.size();
+  method.accept(this);
   assert(nodeStack.size() == 0);
+  if (firmGraphs.size() == numGraphs) {
+    return nullptr; // unreachable
+  }
+  ir_graph *graph = firmGraphs.back();
+  firmGraphs.pop_back();
+  return graph;
 }
 
 void FirmVisitor::visitMainMethod(ast::MainMethod &method) {
@@ -208,7 +226,12 @@ void FirmVisitor::visitMainMethod(ast::MainMethod &method) {
 
 void FirmVisitor::visitRegularMethod(ast::RegularMethod &method) {
   // Types in this->methods have already been created in visitClass!
-  auto firmMethod = &this->methods.at(&method);
+  auto it = this->methods.find(&method);
+  if (it == this->methods.end()) {
+    return; // unreachable, see visitClass
+  }
+  auto firmMethod = &it->second;
+  createMethodGraph(method, *firmMethod);
   auto methodGraph = firmMethod->graph;
   this->currentMethod = &method;
 
@@ -244,6 +267,36 @@ void FirmVisitor::createClassEntity(ast::Class &klass) {
   this->classes.insert({&klass, FirmClass(classEntity)});
 }
 
+void FirmVisitor::createMethodGraph(ast::RegularMethod &method,
+                                    FirmMethod &firmMethod) {
+  int numParams = firmMethod.nParams;
+  auto &localVars = firmMethod.localVars;
+  /* "returns a new graph consisting of a start block, a regular block
+   * and an end block" */
+  ir_graph *methodGraph = new_ir_graph(firmMethod.entity,
+         numParams + localVars.size()); // number of local variables including parameters
+  set_current_ir_graph(methodGraph);
+
+  // Add projections for arguments
+  ir_node *lastBlock = get_r_cur_block(methodGraph);
+  // set the start block to be the current block
+  set_r_cur_block(methodGraph, get_irg_start_block(methodGraph));
+  ir_node *args = get_irg_args(methodGraph);
+
+  ir_node **paramNodes = new ir_node*[numParams];
+  paramNodes[0] = new_Proj(args, mode_P, 0);
+  int i = 1;
+  for(auto &param : method.getParameters()) {
+    paramNodes[i] = new_Proj(args, getIrMode(param->getType()), i);
+    set_value(i, paramNodes[i]); // TODO necessary?
+    i++;
+  }
+
+  set_r_cur_block(methodGraph, lastBlock);
+  firmMethod.graph = methodGraph;
+  firmMethod.params = paramNodes;
+}
+
 void FirmVisitor::visitClass(ast::Class &klass) {
   // We do not recurse into children here since that will be done separately
   // in visitProgram(). Instead, collect the types of all methods and to the same there.
@@ -252,6 +305,11 @@ void FirmVisitor::visitClass(ast::Class &klass) {
 
   auto &methods = klass.getMethods()->getMethods();
   for (auto &method : methods) {
+    if (!callGraph.isReachable(*method)) {
+      // no graph and no entity, nothing can call it
+      ++numSkippedMethods;
+      continue;
+    }
     int numReturnValues = method->getReturnType()->getSemaType().isVoid() ? 0 : 1;
     auto &parameters = method->getParameters();
     ir_type *methodType = new_type_method(parameters.size() + 1, numReturnValues,
@@ -274,31 +332,9 @@ void FirmVisitor::visitClass(ast::Class &klass) {
                                    new_id_from_str(method->getMangledName().c_str()),
                                    methodType);
 
-    auto &localVars = method->getVarDecls();
-    /* "returns a new graph consisting of a start block, a regular block
-     * and an end block" */
-    ir_graph *methodGraph = new_ir_graph(methodEntity,
-           numParams + localVars.size()); // number of local variables including parameters
-    set_current_ir_graph(methodGraph);
-
-    // Add projections for arguments
-    ir_node *lastBlock = get_r_cur_block(methodGraph);
-    // set the start block to be the current block
-    set_r_cur_block(methodGraph, get_irg_start_block(methodGraph));
-    ir_node *args = get_irg_args(methodGraph);
-
-    ir_node **paramNodes = new ir_node*[numParams];
-    paramNodes[0] = new_Proj(args, mode_P, 0);
-    int i = 1;
-    for(auto &param : parameters) {
-      paramNodes[i] = new_Proj(args, getIrMode(param->getType()), i);
-      set_value(i, paramNodes[i]); // TODO necessary?
-      i++;
-    }
-
-    set_r_cur_block(methodGraph, lastBlock);
-    this->methods.insert({method.get(), FirmMethod(methodEntity, (size_t)numParams,
-          paramNodes, localVars, methodGraph)});
+    // the graph is created when the method is built, see createMethodGraph
+    this->methods.insert({method, FirmMethod(methodEntity, (size_t)numParams,
+          nullptr, method->getVarDecls(), nullptr)});
   }
 
   auto &fields = klass.getFields()->getFields();
@@ -310,7 +346,7 @@ void FirmVisitor::visitClass(ast::Class &klass) {
                                 field->getName().c_str(),
                                 fieldType);
     set_entity_offset(ent, offset);
-    firmClass->fieldEntities.push_back(FirmField{field.get(), ent});
+    firmClass->fieldEntities.push_back(FirmField{field, ent});
     offset += get_type_size(fieldType);
   }
 
@@ -327,7 +363,7 @@ void FirmVisitor::visitReturnStatement(ast::ReturnStatement &stmt) {
     stmt.acceptChildren(this);
     popRequiresBoolInfo();
 
-    ir_node *results[] = {popNode()->load()};
+    ir_node *results[] = {popNode().load()};
     ret = new_Return(get_store(), 1, results);
   } else {
     if (dynamic_cast<ast::MainMethod *>(currentMethod)) {
@@ -341,15 +377,76 @@ void FirmVisitor::visitReturnStatement(ast::ReturnStatement &stmt) {
   add_immBlock_pred(end, ret);
 }
 
+void FirmVisitor::visitExpression(ast::Expression &expr) {
+  // Expressions are built from the explicit stack exprStack instead of by
+  // recursion, so their nesting depth is not limited by the call stack.
+  // buildStep advances the expression on top of the stack: it either returns
+  // the next operand to build, whose value is then on the node stack when the
+  // expression is advanced again, or finishes the expression and returns
+  // nullptr.
+  size_t base = exprStack.size();
+  exprStack.emplace_back(&expr);
+  while (exprStack.size() > base) {
+    ast::Expression *operand = buildStep(exprStack.back());
+    if (operand != nullptr) {
+      exprStack.emplace_back(operand);
+    } else {
+      exprStack.pop_back();
+    }
+  }
+}
+
+ast::Expression *FirmVisitor::buildStep(ExprFrame &frame) {
+  switch (frame.expr->getKind()) {
+  case ast::NodeKind::BinaryExpression: {
+    auto &expr = static_cast<ast::BinaryExpression &>(*frame.expr);
+    if (expr.getOperation() == ast::BinaryExpression::Op::And ||
+        expr.getOperation() == ast::BinaryExpression::Op::Or) {
+      return buildShortCircuit(frame, expr);
+    }
+    return buildBinaryOperation(frame, expr);
+  }
+  case ast::NodeKind::UnaryExpression:
+    return buildUnaryExpression(
+        frame, static_cast<ast::UnaryExpression &>(*frame.expr));
+  case ast::NodeKind::MethodInvocation:
+    return buildMethodInvocation(
+        frame, static_cast<ast::MethodInvocation &>(*frame.expr));
+  case ast::NodeKind::FieldAccess:
+    return buildFieldAccess(frame,
+                            static_cast<ast::FieldAccess &>(*frame.expr));
+  case ast::NodeKind::ArrayAccess:
+    return buildArrayAccess(frame,
+                            static_cast<ast::ArrayAccess &>(*frame.expr));
+  case ast::NodeKind::NewArrayExpression:
+    return buildNewArrayExpression(
+        frame, static_cast<ast::NewArrayExpression &>(*frame.expr));
+  default:
+    // literals, variables and new objects have no operands
+    frame.expr->accept(this);
+    return nullptr;
+  }
+}
+
 void FirmVisitor::visitMethodInvocation(ast::MethodInvocation &invocation) {
+  visitExpression(invocation);
+}
+
+ast::Expression *
+FirmVisitor::buildMethodInvocation(ExprFrame &frame,
+                                   ast::MethodInvocation &invocation) {
+  auto &arguments = invocation.getArguments();
   // TODO: We're abusing isSysoutCall for Sysin...
   if (invocation.isSysoutCall()) {
-    invocation.acceptChildren(this);
+    // System.out and System.in have no value, only the arguments are built
+    if (frame.step < arguments.size()) {
+      return arguments[frame.step++];
+    }
     // "to create the call we first create a node representing the address
     //  of the function we want to call" ... "then we use new_Call to
     //  create the call"
     if (invocation.getName() == "println") {
-      ir_node *args[] = {popNode()->load()}; // int argument
+      ir_node *args[] = {popNode().load()}; // int argument
       ir_node *store = get_store();
       ir_node *callee = new_Address(sysoutEntity);
       ir_node *callNode = new_Call(store, callee, 1, args, this->sysoutType);
@@ -359,7 +456,7 @@ void FirmVisitor::visitMethodInvocation(ast::MethodInvocation &invocation) {
       set_store(newStore);
       pushNode(nullptr); // needs to return a node for consistency!
     } else if (invocation.getName() == "write") {
-      ir_node *args[] = {popNode()->load()}; // int argument
+      ir_node *args[] = {popNode().load()}; // int argument
       ir_node *store = get_store();
       ir_node *callee = new_Address(writeEntity);
       ir_node *callNode = new_Call(store, callee, 1, args, this->writeType);
@@ -393,54 +490,57 @@ void FirmVisitor::visitMethodInvocation(ast::MethodInvocation &invocation) {
     } else {
       assert(false);
     }
-  } else {
+    return nullptr;
+  }
 
-    auto left = invocation.getLeft();
-    // This should be true now after semantic analysis
-    assert(left->targetType.isClass());
-    auto leftClass = currentProgram->findClassByName(left->targetType.name);
-    auto leftFirmClass = this->classes.at(leftClass);
+  // the object, then the arguments
+  size_t step = frame.step++;
+  if (step == 0) {
+    pushRequiresNonBool();
+    return invocation.getLeft();
+  }
+  // load each operand right after building it, for the evaluation order
+  pushNode(popNode().load());
+  if (step <= arguments.size()) {
+    return arguments[step - 1];
+  }
+  popRequiresBoolInfo();
 
-    auto firmMethod = &this->methods.at(invocation.getDef());
+  // This should be true now after semantic analysis
+  assert(invocation.getLeft()->targetType.isClass());
 
-    size_t nArgs = 1 + invocation.getArguments().size();
-    std::vector<ir_node *> args;
-    args.resize(nArgs);
+  auto firmMethod = &this->methods.at(invocation.getDef());
 
-    pushRequiresNonBool();
-    left->accept(this);
-    args[0] = popNode()->load();
-    int i = 1;
-    for (auto &arg : invocation.getArguments()) {
-      arg->accept(this);
-      args[i] = popNode()->load();
-      ++i;
-    }
-    popRequiresBoolInfo();
+  size_t nArgs = 1 + arguments.size();
+  std::vector<ir_node *> args;
+  args.resize(nArgs);
+  for (size_t i = nArgs; i-- > 0;) {
+    args[i] = popNode().load();
+  }
 
-    ir_node *store = get_store();
-    ir_node *callee = new_Address(firmMethod->entity);
-    ir_node *callNode =
-        new_Call(store, callee, nArgs, args.data(), firmMethod->type());
+  ir_node *store = get_store();
+  ir_node *callee = new_Address(firmMethod->entity);
+  ir_node *callNode =
+      new_Call(store, callee, nArgs, args.data(), firmMethod->type());
 
-    // Update the current store
-    ir_node *newStore = new_Proj(callNode, get_modeM(), pn_Call_M);
-    set_store(newStore);
+  // Update the current store
+  ir_node *newStore = new_Proj(callNode, get_modeM(), pn_Call_M);
+  set_store(newStore);
 
-    // get the result
-    if (!invocation.targetType.isVoid()) {
-      ir_node *tuple = new_Proj(callNode, mode_T, pn_Call_T_result);
-      ir_node *result = new_Proj(tuple, getIrMode(invocation.targetType), 0);
-      if (requiresBool()) {
-        booleanToControlFlow(result, currentTrueTarget(), currentFalseTarget());
-        pushNode(nullptr);
-      } else {
-        pushNode(result);
-      }
+  // get the result
+  if (!invocation.targetType.isVoid()) {
+    ir_node *tuple = new_Proj(callNode, mode_T, pn_Call_T_result);
+    ir_node *result = new_Proj(tuple, getIrMode(invocation.targetType), 0);
+    if (requiresBool()) {
+      booleanToControlFlow(result, currentTrueTarget(), currentFalseTarget());
+      pushNode(nullptr);
     } else {
-      pushNode(nullptr); // needs to return a node for consistency!
+      pushNode(result);
     }
+  } else {
+    pushNode(nullptr); // needs to return a node for consistency!
   }
+  return nullptr;
 }
 
 void FirmVisitor::visitIntLiteral(ast::IntLiteral &lit) {
@@ -486,153 +586,167 @@ void FirmVisitor::visitNullLiteral(ast::NullLiteral &lit) {
 }
 
 void FirmVisitor::visitBinaryExpression(ast::BinaryExpression &expr) {
-  auto op = expr.getOperation();
-  switch (op) {
-    case ast::BinaryExpression::Op::Or:
-    case ast::BinaryExpression::Op::And: {
-      ir_node *rightBlock = new_immBlock();
-      ir_node *trueTarget;
-      ir_node *falseTarget;
-      if (requiresBool()) {
-        trueTarget = currentTrueTarget();
-        falseTarget = currentFalseTarget();
-      } else {
-        trueTarget = new_immBlock();
-        falseTarget = new_immBlock();
-      }
-      if (op == ast::BinaryExpression::Op::And) {
-        pushRequiresBool(rightBlock, falseTarget);
-      } else {
-        pushRequiresBool(trueTarget, rightBlock);
-      }
-      expr.getLeft()->accept(this);
-      auto node = popNode();
-      assert(node->load() == nullptr);
-      popRequiresBoolInfo();
+  visitExpression(expr);
+}
 
-      mature_immBlock(get_cur_block());
-      set_cur_block(rightBlock);
+// && and ||: the left operand jumps to the right one or to a target of the
+// whole expression. Without a surrounding condition, the targets are new
+// blocks which are joined to a boolean value.
+ast::Expression *FirmVisitor::buildShortCircuit(ExprFrame &frame,
+                                                ast::BinaryExpression &expr) {
+  switch (frame.step++) {
+  case 0:
+    frame.rightBlock = new_immBlock();
+    if (requiresBool()) {
+      frame.trueTarget = currentTrueTarget();
+      frame.falseTarget = currentFalseTarget();
+    } else {
+      frame.trueTarget = new_immBlock();
+      frame.falseTarget = new_immBlock();
+    }
+    if (expr.getOperation() == ast::BinaryExpression::Op::And) {
+      pushRequiresBool(frame.rightBlock, frame.falseTarget);
+    } else {
+      pushRequiresBool(frame.trueTarget, frame.rightBlock);
+    }
+    return expr.getLeft();
+  case 1: {
+    auto node = popNode();
+    assert(node.load() == nullptr);
+    popRequiresBoolInfo();
 
-      pushRequiresBool(trueTarget, falseTarget);
-      expr.getRight()->accept(this);
-      auto node2 = popNode();
-      assert(node2->load() == nullptr);
-      popRequiresBoolInfo();
-      mature_immBlock(rightBlock);
+    mature_immBlock(get_cur_block());
+    set_cur_block(frame.rightBlock);
 
-      if (requiresBool()) {
-        pushNode(nullptr);
-      } else {
-        set_cur_block(falseTarget);
-        auto falseJmp = new_Jmp();
-        mature_immBlock(falseTarget);
+    pushRequiresBool(frame.trueTarget, frame.falseTarget);
+    return expr.getRight();
+  }
+  }
+  auto node2 = popNode();
+  assert(node2.load() == nullptr);
+  popRequiresBoolInfo();
+  mature_immBlock(frame.rightBlock);
 
-        set_cur_block(trueTarget);
-        auto trueJmp = new_Jmp();
-        mature_immBlock(trueTarget);
+  if (requiresBool()) {
+    pushNode(nullptr);
+  } else {
+    set_cur_block(frame.falseTarget);
+    auto falseJmp = new_Jmp();
+    mature_immBlock(frame.falseTarget);
 
-        pushNode(controlFlowToBoolean(falseJmp, trueJmp));
-      }
+    set_cur_block(frame.trueTarget);
+    auto trueJmp = new_Jmp();
+    mature_immBlock(frame.trueTarget);
+
+    pushNode(controlFlowToBoolean(falseJmp, trueJmp));
+  }
+  return nullptr;
+}
+
+ast::Expression *
+FirmVisitor::buildBinaryOperation(ExprFrame &frame,
+                                  ast::BinaryExpression &expr) {
+  auto op = expr.getOperation();
+  switch (frame.step++) {
+  case 0:
+    pushRequiresNonBool();
+    return expr.getLeft();
+  case 1:
+    if (op != ast::BinaryExpression::Op::Assign) {
+      pushNode(popNode().load()); // enforce correct evaluation order!
+      // don't make a load for the Assign case, since we will do a store later instead!
+    }
+    return expr.getRight();
+  }
+  auto rightNode = popNode();
+  auto rightVal = rightNode.load();
+  auto leftNode = popNode();
+  ir_node *leftVal =
+      op != ast::BinaryExpression::Op::Assign ? leftNode.load() : nullptr;
+  ir_node* outNode = nullptr;
+  bool is_boolean = false;
+  popRequiresBoolInfo();
+
+  switch (op) {
+    case ast::BinaryExpression::Op::Assign: {
+      leftNode.store(rightVal);
+      outNode = rightVal;
       break;
     }
-    default: {
-      pushRequiresNonBool();
-      expr.getLeft()->accept(this);
-      auto leftNode = popNode();
-      ir_node *leftVal;
-      if (op != ast::BinaryExpression::Op::Assign) {
-        leftVal = leftNode->load(); // enforce correct evaluation order!
-        // don't make a load for the Assign case, since we will do a store later instead!
-      }
-      expr.getRight()->accept(this);
-      auto rightNode = popNode();
-      auto rightVal = rightNode->load();
-      ir_node* outNode = nullptr;
-      bool is_boolean = false;
-      popRequiresBoolInfo();
-
-      switch (op) {
-        case ast::BinaryExpression::Op::Assign: {
-          leftNode->store(rightVal);
-          outNode = rightVal;
-          break;
-        }
-        case ast::BinaryExpression::Op::Equals:
-          outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_equal));
-          is_boolean = true;
-          break;
-        case ast::BinaryExpression::Op::NotEquals:
-          outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_less_greater));
-          is_boolean = true;
-          break;
-        case ast::BinaryExpression::Op::Less:
-          outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_less));
-          is_boolean = true;
-          break;
-        case ast::BinaryExpression::Op::LessEquals:
-          outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_less_equal));
-          is_boolean = true;
-          break;
-        case ast::BinaryExpression::Op::Greater:
-          outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_greater));
-          is_boolean = true;
-          break;
-        case ast::BinaryExpression::Op::GreaterEquals:
-          outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_greater_equal));
-          is_boolean = true;
-          break;
-        case ast::BinaryExpression::Op::Plus:
-          outNode = new_Add(leftVal, rightVal);
-          break;
-        case ast::BinaryExpression::Op::Minus:
-          outNode = new_Sub(leftVal, rightVal);
-          break;
-        case ast::BinaryExpression::Op::Mul:
-          outNode = new_Mul(leftVal, rightVal);
-          break;
-        case ast::BinaryExpression::Op::Div: {
-          ir_node *divNode = new_DivRL(get_store(),
-                  new_Conv(leftVal, mode_Ls),
-                  new_Conv(rightVal, mode_Ls),
-                  op_pin_state_pinned);
-          set_store(new_Proj(divNode, mode_M, pn_Div_M));
-          ir_node *resNode = new_Proj(divNode, mode_Ls, pn_Div_res);
-          outNode = new_Conv(resNode, mode_Is);
-          break;
-        }
-        case ast::BinaryExpression::Op::Mod: {
-          ir_node *modNode = new_Mod(get_store(),
-                  new_Conv(leftVal, mode_Ls),
-                  new_Conv(rightVal, mode_Ls),
-                  op_pin_state_pinned);
-          set_store(new_Proj(modNode, mode_M, pn_Mod_M));
-          ir_node *resNode = new_Proj(modNode, mode_Ls, pn_Mod_res);
-          outNode = new_Conv(resNode, mode_Is);
-          break;
-        }
-        default:
-          __builtin_trap();
-          break;
-      }
-      assert(outNode);
-      if(requiresBool()) {
-        if (is_boolean) {
-          ir_node *projTrue = new_Proj(outNode, mode_X, pn_Cond_true);
-          ir_node *projFalse = new_Proj(outNode, mode_X, pn_Cond_false);
-          add_immBlock_pred(currentTrueTarget(), projTrue);
-          add_immBlock_pred(currentFalseTarget(), projFalse);
-          outNode = nullptr; // dummy
-        } else { // regular mode_Bu value (only from assigment to boolean)
-          booleanToControlFlow(outNode, currentTrueTarget(), currentFalseTarget());
-          outNode = nullptr;
-        }
-      } else if (is_boolean) {
-        outNode = condToBoolean(outNode);
-      }
-      pushNode(outNode);
+    case ast::BinaryExpression::Op::Equals:
+      outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_equal));
+      is_boolean = true;
+      break;
+    case ast::BinaryExpression::Op::NotEquals:
+      outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_less_greater));
+      is_boolean = true;
+      break;
+    case ast::BinaryExpression::Op::Less:
+      outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_less));
+      is_boolean = true;
+      break;
+    case ast::BinaryExpression::Op::LessEquals:
+      outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_less_equal));
+      is_boolean = true;
+      break;
+    case ast::BinaryExpression::Op::Greater:
+      outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_greater));
+      is_boolean = true;
+      break;
+    case ast::BinaryExpression::Op::GreaterEquals:
+      outNode = new_Cond(new_Cmp(leftVal, rightVal, ir_relation_greater_equal));
+      is_boolean = true;
+      break;
+    case ast::BinaryExpression::Op::Plus:
+      outNode = new_Add(leftVal, rightVal);
+      break;
+    case ast::BinaryExpression::Op::Minus:
+      outNode = new_Sub(leftVal, rightVal);
+      break;
+    case ast::BinaryExpression::Op::Mul:
+      outNode = new_Mul(leftVal, rightVal);
+      break;
+    case ast::BinaryExpression::Op::Div: {
+      ir_node *divNode = new_DivRL(get_store(),
+              new_Conv(leftVal, mode_Ls),
+              new_Conv(rightVal, mode_Ls),
+              op_pin_state_pinned);
+      set_store(new_Proj(divNode, mode_M, pn_Div_M));
+      ir_node *resNode = new_Proj(divNode, mode_Ls, pn_Div_res);
+      outNode = new_Conv(resNode, mode_Is);
+      break;
+    }
+    case ast::BinaryExpression::Op::Mod: {
+      ir_node *modNode = new_Mod(get_store(),
+              new_Conv(leftVal, mode_Ls),
+              new_Conv(rightVal, mode_Ls),
+              op_pin_state_pinned);
+      set_store(new_Proj(modNode, mode_M, pn_Mod_M));
+      ir_node *resNode = new_Proj(modNode, mode_Ls, pn_Mod_res);
+      outNode = new_Conv(resNode, mode_Is);
       break;
     }
+    default:
+      __builtin_trap();
+      break;
   }
+  assert(outNode);
+  if(requiresBool()) {
+    if (is_boolean) {
+      ir_node *projTrue = new_Proj(outNode, mode_X, pn_Cond_true);
+      ir_node *projFalse = new_Proj(outNode, mode_X, pn_Cond_false);
+      add_immBlock_pred(currentTrueTarget(), projTrue);
+      add_immBlock_pred(currentFalseTarget(), projFalse);
+      outNode = nullptr; // dummy
+    } else { // regular mode_Bu value (only from assigment to boolean)
+      booleanToControlFlow(outNode, currentTrueTarget(), currentFalseTarget());
+      outNode = nullptr;
+    }
+  } else if (is_boolean) {
+    outNode = condToBoolean(outNode);
+  }
+  pushNode(outNode);
+  return nullptr;
 }
 
 void FirmVisitor::visitVarRef(ast::VarRef &ref) {
@@ -646,14 +760,14 @@ void FirmVisitor::visitVarRef(ast::VarRef &ref) {
 //     auto method = dynamic_cast<ast::RegularMethod*>(this->currentMethod);
     size_t paramIndex = param->getIndex();
     assert(paramIndex < this->methods.at(this->currentMethod).nParams);
-    pushNode(std::make_unique<VarValue>(paramIndex, getIrMode(param->getType())));
+    pushNode(Value::var(paramIndex, getIrMode(param->getType())));
   } else if (auto decl = dynamic_cast<ast::VariableDeclaration*>(ref.getDef())) {
     auto firmMethod = &methods.at(this->currentMethod);
     size_t varIndex = firmMethod->nParams; // first parameters, then local vars
     varIndex += decl->getIndex();
     //     ir_node *val = get_r_value (current_ir_graph, varIndex,
 //                                 getIrMode(decl->getType()));
-    pushNode(std::make_unique<VarValue>(varIndex, getIrMode(decl->getType())));
+    pushNode(Value::var(varIndex, getIrMode(decl->getType())));
   } else if (auto field = dynamic_cast<ast::Field*>(ref.getDef())) {
     auto firmClass = &classes.at(this->currentClass);
     for (auto &fieldEnt : firmClass->fieldEntities) {
@@ -662,7 +776,7 @@ void FirmVisitor::visitVarRef(ast::VarRef &ref) {
         ir_node *thisPointer = firmMethod->params[0];
         ir_node *member = new_Member(thisPointer, fieldEnt.entity);
         assert(is_Member(member));
-        pushNode(std::make_unique<FieldValue>(member));
+        pushNode(Value::field(member));
         break;
       }
     }
@@ -671,45 +785,51 @@ void FirmVisitor::visitVarRef(ast::VarRef &ref) {
   }
   // don't do control flow from arrays, do it in the ArrayAccess
   auto out = popNode();
-  if (requiresBool() && out->getMode() == mode_Bu) {
-    booleanToControlFlow(out->load(), currentTrueTarget(), currentFalseTarget());
+  if (requiresBool() && out.getMode() == mode_Bu) {
+    booleanToControlFlow(out.load(), currentTrueTarget(), currentFalseTarget());
     pushNode(nullptr);
   } else {
-    pushNode(std::move(out));
+    pushNode(out);
   }
 }
 
 void FirmVisitor::visitUnaryExpression(ast::UnaryExpression &expr) {
+  visitExpression(expr);
+}
+
+ast::Expression *FirmVisitor::buildUnaryExpression(ExprFrame &frame,
+                                                   ast::UnaryExpression &expr) {
   switch(expr.getOperation()) {
   case ast::UnaryExpression::Op::Not: {
-    bool need_phi = false; // need to convert to bool
-    ir_node *trueTarget = nullptr;
-    ir_node *falseTarget = nullptr;
-    if(!requiresBool()) {
-      mature_immBlock(get_cur_block());
+    if (frame.step++ == 0) {
+      if(!requiresBool()) {
+        mature_immBlock(get_cur_block());
 
-      // same Block, 'Not' is implemented by switching Projection order below
-      trueTarget = falseTarget = new_immBlock();
+        // same Block, 'Not' is implemented by switching Projection order below
+        frame.trueTarget = frame.falseTarget = new_immBlock();
 
-      need_phi = true;
-    } else {
-      trueTarget = currentTrueTarget();
-      falseTarget = currentFalseTarget();
-    }
+        frame.needPhi = true; // need to convert to bool
+      } else {
+        frame.trueTarget = currentTrueTarget();
+        frame.falseTarget = currentFalseTarget();
+      }
 
-    pushRequiresBool(falseTarget, trueTarget); // swapped
-    expr.acceptChildren(this);
+      pushRequiresBool(frame.falseTarget, frame.trueTarget); // swapped
+      return expr.getExpression();
+    }
     auto node = popNode();
-    assert(node->load() == nullptr);
+    assert(node.load() == nullptr);
     popRequiresBoolInfo();
 
-    if (trueTarget == falseTarget && get_Block_n_cfgpreds(trueTarget) == 2) {
+    ir_node *trueTarget = frame.trueTarget;
+    if (trueTarget == frame.falseTarget &&
+        get_Block_n_cfgpreds(trueTarget) == 2) {
       ir_node *trueProj = get_Block_cfgpred(trueTarget, 0);
       ir_node *falseProj = get_Block_cfgpred(trueTarget, 1);
       set_Block_cfgpred(trueTarget, 0, falseProj);
       set_Block_cfgpred(trueTarget, 1, trueProj);
     }
-    if (need_phi) {
+    if (frame.needPhi) {
       mature_immBlock(get_cur_block());
       set_cur_block(trueTarget);
 
@@ -718,31 +838,33 @@ void FirmVisitor::visitUnaryExpression(ast::UnaryExpression &expr) {
 
       ir_node* const PhiIn[] = { trueNode, falseNode };
       pushNode(new_Phi(2, PhiIn, mode_Bu));
-      trueTarget = falseTarget = nullptr;
       mature_immBlock(get_cur_block());
     } else {
       pushNode(nullptr);
     }
-    break;
+    return nullptr;
   }
   case ast::UnaryExpression::Op::Neg:
-    expr.acceptChildren(this);
-    pushNode(new_Minus(popNode()->load()));
-    break;
+    if (frame.step++ == 0) {
+      return expr.getExpression();
+    }
+    pushNode(new_Minus(popNode().load()));
+    return nullptr;
   default:
     assert(false);
+    return nullptr;
   }
 }
 
 void FirmVisitor::visitVariableDeclaration(ast::VariableDeclaration &decl) {
   if (decl.getInitializer() != nullptr) {
     // TODO: fix for bools, generalize static helper -> see also UnaryExpr
-    decl.getInitializer()->accept(this);
+    visitExpression(*decl.getInitializer());
     auto firmMethod = &methods.at(this->currentMethod);
     size_t pos = firmMethod->nParams; // first parameters, then local vars
     pos += decl.getIndex();
 
-    set_r_value(current_ir_graph, pos, popNode()->load());
+    set_r_value(current_ir_graph, pos, popNode().load());
   }
 }
 
@@ -751,20 +873,27 @@ void FirmVisitor::visitField(ast::Field &field) {
 }
 
 void FirmVisitor::visitFieldAccess(ast::FieldAccess &access) {
+  visitExpression(access);
+}
+
+ast::Expression *FirmVisitor::buildFieldAccess(ExprFrame &frame,
+                                               ast::FieldAccess &access) {
   // sysout special case...
   if (access.getDef() == &ast::FieldAccess::dummySystemOut ||
       access.getDef() == &ast::FieldAccess::dummySystemIn) {
-    return;
+    return nullptr;
   }
-  auto firmClass = &classes.at(
-      currentProgram->findClassByName(access.getLeft()->targetType.name));
   // Left is never null!
-  pushRequiresNonBool();
-  access.getLeft()->accept(this);
+  if (frame.step++ == 0) {
+    pushRequiresNonBool();
+    return access.getLeft();
+  }
   popRequiresBoolInfo();
-  ir_node *leftNode = popNode()->load();
+  ir_node *leftNode = popNode().load();
   assert(get_irn_mode(leftNode) == mode_P);
 
+  auto firmClass = &classes.at(
+      currentProgram->findClass(access.getLeft()->targetType.classId));
   ir_entity *rightEntity = nullptr;
   for(auto &fieldEntity : firmClass->fieldEntities)
     if (fieldEntity.field == access.getDef()) {
@@ -775,14 +904,15 @@ void FirmVisitor::visitFieldAccess(ast::FieldAccess &access) {
 
 
   ir_node *member = new_Member(leftNode, rightEntity);
-  auto memberAccess = std::make_unique<FieldValue>(member);
+  auto memberAccess = Value::field(member);
 
   if (requiresBool()) {
-    booleanToControlFlow(memberAccess->load(), currentTrueTarget(), currentFalseTarget());
+    booleanToControlFlow(memberAccess.load(), currentTrueTarget(), currentFalseTarget());
     pushNode(nullptr);
   } else {
-    pushNode(std::move(memberAccess));
+    pushNode(memberAccess);
   }
+  return nullptr;
 }
 
 void FirmVisitor::visitNewObjectExpression(ast::NewObjectExpression &expr) {
@@ -803,12 +933,24 @@ void FirmVisitor::visitNewObjectExpression(ast::NewObjectExpression &expr) {
 
 void FirmVisitor::visitArrayAccess(ast::ArrayAccess& arrayAccess)
 {
-  pushRequiresNonBool();
-  arrayAccess.getArray()->accept(this);
-  ir_node *arrayAddrNode = popNode()->load();
-  assert(get_irn_mode(arrayAddrNode) == mode_P);
-  arrayAccess.getIndex()->accept(this);
-  ir_node *indexNode = popNode()->load();
+  visitExpression(arrayAccess);
+}
+
+ast::Expression *FirmVisitor::buildArrayAccess(ExprFrame &frame,
+                                               ast::ArrayAccess &arrayAccess) {
+  switch (frame.step++) {
+  case 0:
+    pushRequiresNonBool();
+    return arrayAccess.getArray();
+  case 1: {
+    ir_node *arrayAddrNode = popNode().load();
+    assert(get_irn_mode(arrayAddrNode) == mode_P);
+    pushNode(arrayAddrNode);
+    return arrayAccess.getIndex();
+  }
+  }
+  ir_node *indexNode = popNode().load();
+  ir_node *arrayAddrNode = popNode().load();
   ir_type *arrayType = get_pointer_points_to_type(getIrType(arrayAccess.getArray()->targetType));
   // do a select directly on the pointer-to-array type
   ir_node *sel = new_Sel(arrayAddrNode, indexNode, arrayType);
@@ -818,21 +960,30 @@ void FirmVisitor::visitArrayAccess(ast::ArrayAccess& arrayAccess)
 
   auto elementType =
       getIrType(arrayAccess.getArray()->targetType.getArrayInnerType());
-  pushNode(std::make_unique<ArrayValue>(sel, elementType));
+  pushNode(Value::array(sel, elementType));
 
   if (requiresBool()) {
-    booleanToControlFlow(popNode()->load(), currentTrueTarget(), currentFalseTarget());
+    booleanToControlFlow(popNode().load(), currentTrueTarget(), currentFalseTarget());
     pushNode(nullptr);
   }
+  return nullptr;
 }
 
 void FirmVisitor::visitNewArrayExpression(ast::NewArrayExpression &expr) {
-  pushRequiresNonBool();
-  expr.getSize()->accept(this);
+  visitExpression(expr);
+}
+
+ast::Expression *
+FirmVisitor::buildNewArrayExpression(ExprFrame &frame,
+                                     ast::NewArrayExpression &expr) {
+  if (frame.step++ == 0) {
+    pushRequiresNonBool();
+    return expr.getSize();
+  }
   popRequiresBoolInfo();
 
   auto elementType = getIrType(expr.getArrayType()->getSemaType().getArrayInnerType());
-  ir_node *args[2] = {new_Conv(popNode()->load(), mode_Ls), new_Size(mode_Ls, elementType)};
+  ir_node *args[2] = {new_Conv(popNode().load(), mode_Ls), new_Size(mode_Ls, elementType)};
   ir_node *store = get_store();
   ir_node *callee = new_Address(callocEntity);
   ir_node *callNode = new_Call(store, callee, 2, args, get_entity_type(callocEntity));
@@ -843,6 +994,7 @@ void FirmVisitor::visitNewArrayExpression(ast::NewArrayExpression &expr) {
   ir_node *result = new_Proj(tuple, mode_P, 0);
 
   pushNode(result);
+  return nullptr;
 }
 
 void FirmVisitor::visitExpressionStatement(ast::ExpressionStatement &exprStmt) {
@@ -857,9 +1009,9 @@ void FirmVisitor::visitIfStatement(ast::IfStatement &stmt) {
   auto elseBlock = (stmt.getElseStatement() != nullptr) ? new_immBlock() : afterBlock;
 
   pushRequiresBool(thenBlock, elseBlock);
-  stmt.getCondition()->accept(this);
+  visitExpression(*stmt.getCondition());
   auto node = popNode(); // discard nullptr
-  assert(node->load() == nullptr);
+  assert(node.load() == nullptr);
   popRequiresBoolInfo();
 
   if (thenBlock != afterBlock)
@@ -903,9 +1055,9 @@ void FirmVisitor::visitWhileStatement(ast::WhileStatement &stmt) {
   auto afterBlock = new_immBlock();
 
   pushRequiresBool(loopBlock, afterBlock);
-  stmt.getCondition()->accept(this);
+  visitExpression(*stmt.getCondition());
   auto node = popNode(); // discard
-  assert(node->load() == nullptr);
+  assert(node.load() == nullptr);
   popRequiresBoolInfo();
 
   mature_immBlock(loopBlock);
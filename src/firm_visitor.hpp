@@ -3,110 +3,138 @@
 
 #include <memory>
 #include <stack>
+#include <type_traits>
+#include <vector>
 
 #include "ast.hpp"
+#include "call_graph_visitor.hpp"
 #include <libfirm/firm.h>
 
 
+// Result of an expression on the FirmVisitor's node stack: either a value
+// or a location which is only loaded or stored when it is used, so the left
+// side of an assignment is never loaded. Held by value, building a node
+// needs no heap allocation and no virtual call.
 class Value {
-protected:
 public:
-  virtual ir_node *load() { __builtin_trap(); }
-  virtual void store(ir_node *) { __builtin_trap(); }
-  virtual ir_mode *getMode() { __builtin_trap(); }
-  operator ir_node *() { return load(); }
-  virtual ~Value() {}
+  enum class Kind : uint8_t {
+    RValue, // node is the value, might be nullptr for control flow
+    Var,    // local variable or parameter varIndex of mode
+    Field,  // node is the Member of the field
+    Array,  // node is the Sel of the element of elemType
+  };
+
+private:
+  Kind kind;
+  union {
+    ir_node *node;
+    size_t varIndex;
+  };
+  union {
+    ir_mode *mode;
+    ir_type *elemType;
+  };
+
+  Value(Kind kind) : kind(kind), node(nullptr), mode(nullptr) {}
 
-  static ir_mode *getModeForType(ir_type *t) {
-    if (is_Array_type(t)) {
-      return mode_P;
-    }
-    return get_type_mode(t);
-  }
-};
-class VarValue : public Value {
-  size_t varIndex;
-  ir_mode *mode;
 public:
-  VarValue(size_t index, ir_mode *mode) : varIndex(index), mode(mode) {
-    assert(mode);
-  }
-  VarValue(size_t index, ir_type *type)
-  : VarValue(index, get_type_mode(type)) {}
-  ir_node *load() override {
-    return get_value(varIndex, mode);
+  static Value rvalue(ir_node *val) {
+    Value v(Kind::RValue);
+    v.node = val;
+    return v;
   }
-  void store(ir_node *val) override {
-    set_value(varIndex, val);
+  static Value var(size_t index, ir_mode *mode) {
+    assert(mode);
+    Value v(Kind::Var);
+    v.varIndex = index;
+    v.mode = mode;
+    return v;
   }
-  ir_mode *getMode() override { return mode; }
-};
-class FieldValue : public Value {
-  ir_node * member;
-public:
-  FieldValue(ir_node *member) : member(member) {
+  static Value field(ir_node *member) {
     assert(member);
+    Value v(Kind::Field);
+    v.node = member;
+    return v;
   }
-  ir_node *load() override {
-    ir_type *type = get_entity_type(get_Member_entity(member));
-    assert(type);
-    ir_mode *mode = getMode();
-    assert(mode);
-//     ir_printf("load field; type: %t, mode: %m\n", type, mode);
-    ir_node *loadNode = new_Load(get_store(), member, mode, type, cons_none);
-    ir_node *projRes  = new_Proj(loadNode, mode, pn_Load_res);
-    ir_node *projM    = new_Proj(loadNode, mode_M, pn_Load_M);
-    set_store(projM);
-    return projRes;
+  static Value array(ir_node *sel, ir_type *elemType) {
+    assert(sel);
+    assert(elemType);
+    Value v(Kind::Array);
+    v.node = sel;
+    v.elemType = elemType;
+    return v;
   }
-  void store(ir_node *val) override {
-    ir_type *type = get_entity_type(get_Member_entity(member));
-    assert(type);
-//     ir_printf("store field; type: %t\n", type);
-    ir_node *storeNode = new_Store(get_store(), member, val, type, cons_none);
-    ir_node *projM    = new_Proj(storeNode, mode_M, pn_Load_M);
-    set_store(projM);
+
+  ir_node *load() const {
+    switch (kind) {
+    case Kind::RValue:
+      return node;
+    case Kind::Var:
+      return get_value(varIndex, mode);
+    case Kind::Field:
+    case Kind::Array: {
+      ir_mode *loadMode = getMode();
+      ir_node *loadNode = new_Load(get_store(), node, loadMode, getType(),
+                                   cons_none);
+      ir_node *projRes = new_Proj(loadNode, loadMode, pn_Load_res);
+      ir_node *projM = new_Proj(loadNode, mode_M, pn_Load_M);
+      set_store(projM);
+      return projRes;
+    }
+    }
+    __builtin_trap();
   }
-  ir_mode *getMode() override {
-    ir_type *type = get_entity_type(get_Member_entity(member));
-    assert(type);
-    return getModeForType(type);
+  void store(ir_node *val) const {
+    switch (kind) {
+    case Kind::Var:
+      set_value(varIndex, val);
+      return;
+    case Kind::Field:
+    case Kind::Array: {
+      ir_node *storeNode = new_Store(get_store(), node, val, getType(),
+                                     cons_none);
+      set_store(new_Proj(storeNode, mode_M, pn_Store_M));
+      return;
+    }
+    case Kind::RValue:
+      break;
+    }
+    __builtin_trap();
   }
-};
-class ArrayValue : public Value {
-  ir_node *selNode;
-  ir_type *elemType;
-public:
-  ArrayValue(ir_node *sel, ir_type *elemType) : selNode(sel), elemType(elemType) {
-    assert(selNode);
-    assert(elemType);
+  ir_mode *getMode() const {
+    switch (kind) {
+    case Kind::RValue:
+      return get_irn_mode(node);
+    case Kind::Var:
+      return mode;
+    case Kind::Field:
+    case Kind::Array:
+      return getModeForType(getType());
+    }
+    __builtin_trap();
   }
-  ir_node *load() override {
-    ir_mode *mode = getMode();
-//     ir_printf("load array; element type: %t, mode: %m\n", elemType, mode);
-    ir_node *loadNode = new_Load(get_store(), selNode, mode, elemType, cons_none);
-    ir_node *projM = new_Proj(loadNode, mode_M, pn_Load_M);
-    ir_node *projRes = new_Proj(loadNode, mode, pn_Load_res);
-    set_store(projM);
-    return projRes;
+  operator ir_node *() const { return load(); }
+
+  static ir_mode *getModeForType(ir_type *t) {
+    if (is_Array_type(t)) {
+      return mode_P;
+    }
+    return get_type_mode(t);
   }
-  void store(ir_node *val) override {
-//     ir_printf("store array; element type: %t\n", elemType);
-    ir_node *storeNode = new_Store(get_store(), selNode, val, elemType, cons_none);
-    ir_node *projM = new_Proj(storeNode, mode_M, pn_Load_M);
-    set_store(projM);
+
+private:
+  // type of the memory location of a Field or Array
+  ir_type *getType() const {
+    if (kind == Kind::Field) {
+      ir_type *type = get_entity_type(get_Member_entity(node));
+      assert(type);
+      return type;
+    }
+    return elemType;
   }
-  ir_mode *getMode() override { return getModeForType(elemType); }
 };
-class RValue : public Value {
-  ir_node *value;
-public:
-  RValue(ir_node *val) : value(val) {}
-  ir_node * load() override { return value; }
-  ir_mode *getMode() override { return get_irn_mode(value); }
-};
-
-using ValuePtr = std::unique_ptr<Value>;
+static_assert(std::is_trivially_copyable<Value>::value,
+              "Values are copied around on the node stack");
 
 struct FirmMethod {
   ir_graph *graph;
@@ -185,9 +213,29 @@ private:
 
   std::unordered_map<ast::Class *, FirmClass> classes;
   std::unordered_map<ast::Method *, FirmMethod> methods;
+  // graphs are only built for methods reachable from main
+  CallGraphVisitor callGraph;
+  size_t numSkippedMethods = 0;
 
-  std::stack<ValuePtr> nodeStack;
+  std::vector<Value> nodeStack;
   std::stack<BoolReqInfo> reqBoolInfo;
+
+  // an expression whose operands are being built, see visitExpression
+  struct ExprFrame {
+    explicit ExprFrame(ast::Expression *expr) : expr(expr) {}
+
+    ast::Expression *expr;
+    // number of operands handed out so far
+    size_t step = 0;
+    // && and ||: the block of the right operand
+    ir_node *rightBlock = nullptr;
+    // && || and !: the targets of the whole expression
+    ir_node *trueTarget = nullptr;
+    ir_node *falseTarget = nullptr;
+    // !: the targets are joined to a boolean value
+    bool needPhi = false;
+  };
+  std::vector<ExprFrame> exprStack;
   // targets for fumps from boolean returning expressions
 //   ir_node *trueTarget = nullptr;
 //   ir_node *falseTarget = nullptr;
@@ -209,7 +257,7 @@ private:
       return new_type_pointer(new_type_array(getIrType(innerType), 0));
     }
     case sem::TypeKind::Class: {
-      auto cls = this->currentProgram->findClassByName(type.name);
+      auto cls = this->currentProgram->findClass(type.classId);
       assert(cls);
       return new_type_pointer(this->classes.at(cls).type());
     }
@@ -262,18 +310,18 @@ private:
 //     return phi;
 //   }
 
-  void pushNode(ValuePtr node) {
-    nodeStack.push(std::move(node));
+  void pushNode(Value node) {
+    nodeStack.push_back(node);
   }
 
   void pushNode(ir_node* node) {
-    nodeStack.push(std::make_unique<RValue>(node));
+    nodeStack.push_back(Value::rvalue(node));
   }
 
-  ValuePtr popNode() {
+  Value popNode() {
     assert(nodeStack.size() > 0);
-    ValuePtr n = std::move(nodeStack.top());
-    nodeStack.pop();
+    Value n = nodeStack.back();
+    nodeStack.pop_back();
 
     return n;
   }
@@ -329,6 +377,22 @@ private:
     }
   }
   void makeStore(ir_node* dest, ir_node* value);
+  ast::Expression *buildStep(ExprFrame &frame);
+  ast::Expression *buildShortCircuit(ExprFrame &frame,
+                                     ast::BinaryExpression &expr);
+  ast::Expression *buildBinaryOperation(ExprFrame &frame,
+                                        ast::BinaryExpression &expr);
+  ast::Expression *buildUnaryExpression(ExprFrame &frame,
+                                        ast::UnaryExpression &expr);
+  ast::Expression *buildMethodInvocation(ExprFrame &frame,
+                                         ast::MethodInvocation &invocation);
+  ast::Expression *buildFieldAccess(ExprFrame &frame,
+                                    ast::FieldAccess &access);
+  ast::Expression *buildArrayAccess(ExprFrame &frame,
+                                    ast::ArrayAccess &arrayAccess);
+  ast::Expression *buildNewArrayExpression(ExprFrame &frame,
+                                           ast::NewArrayExpression &expr);
+  void createMethodGraph(ast::RegularMethod &method, FirmMethod &firmMethod);
 
 public:
   FirmVisitor(bool print);
@@ -345,8 +409,14 @@ public:
   };
 
   std::vector<ir_graph*> &getFirmGraphs() { return firmGraphs; }
+  size_t getNumSkippedMethods() const { return numSkippedMethods; }
 
   void visitProgram(ast::Program &program) override;
+  // creates the types and entities of all classes and methods, but no graphs
+  void declareProgram(ast::Program &program);
+  // builds the graph of a method of a declared program, returns nullptr if
+  // the method isn't reachable. The graph is not added to getFirmGraphs
+  ir_graph *buildGraph(ast::Class &klass, ast::Method &method);
   void visitMainMethod(ast::MainMethod &method) override;
   void visitRegularMethod(ast::RegularMethod &method) override;
   void createClassEntity(ast::Class &klass);
@@ -369,6 +439,7 @@ public:
   void visitExpressionStatement(ast::ExpressionStatement &) override;
   void visitIfStatement(ast::IfStatement &stmt) override;
   void visitWhileStatement(ast::WhileStatement &whileStatement) override;
+  void visitExpression(ast::Expression &expr) override;
 
   // unimplemented:
 //   void visitParameter(ast::Parameter &parameter) override { (void)parameter; assert(false); }
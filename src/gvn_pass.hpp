@@ -0,0 +1,243 @@
+#ifndef GVN_PASS
+#define GVN_PASS
+
+#include "firm_pass.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Global value numbering. Walks the dominator tree and replaces every node
+// which computes the same value as a node in a dominating position by that
+// node, including loads which read the same address in the same memory
+// state. Pessimistic: values flowing around loops through Phis aren't
+// recognized as equal.
+class GvnPass : public FunctionPass<GvnPass> {
+  struct ValueKey {
+    unsigned opcode;
+    ir_mode *mode;
+    // constant, entity, Proj number, relation or loaded mode
+    uintptr_t attr;
+    // only set for nodes which have to stay in their block
+    ir_node *block;
+    ir_node *in[3];
+
+    bool operator==(const ValueKey &o) const {
+      return opcode == o.opcode && mode == o.mode && attr == o.attr &&
+             block == o.block && in[0] == o.in[0] && in[1] == o.in[1] &&
+             in[2] == o.in[2];
+    }
+  };
+
+  struct ValueKeyHash {
+    size_t operator()(const ValueKey &key) const {
+      size_t hash = key.opcode;
+      auto combine = [&hash](const void *p) {
+        hash = hash * 31 + std::hash<const void *>()(p);
+      };
+      combine(key.mode);
+      combine(reinterpret_cast<const void *>(key.attr));
+      combine(key.block);
+      for (auto in : key.in) {
+        combine(in);
+      }
+      return hash;
+    }
+  };
+
+  std::unordered_map<ValueKey, ir_node *, ValueKeyHash> values;
+  // keys in the order they were added and where the keys of each block on
+  // the current dominator tree path start, to forget them when leaving it
+  std::vector<ValueKey> addedKeys;
+  std::vector<size_t> scopes;
+  std::unordered_map<ir_node *, std::vector<ir_node *>> blockNodes;
+  unsigned replaced = 0;
+
+public:
+  GvnPass(ir_graph *firmgraph) : FunctionPass(firmgraph) {
+    assure_doms(graph);
+  }
+
+  void before() { edges_activate(graph); }
+
+  // constants are duplicated while building the graph, merge them as well
+  void initConst(ir_node *node) { enqueue(node); }
+
+  // in topological order, operands are numbered before their users
+  void defaultVisitOp(ir_node *node) {
+    if (!is_Block(node)) {
+      blockNodes[get_nodes_block(node)].push_back(node);
+    }
+  }
+
+  void after() {
+    dom_tree_walk_irg(graph, enterBlock, leaveBlock, this);
+    changed = replaced > 0;
+    edges_deactivate(graph);
+  }
+
+  unsigned getNumChanges() const { return replaced; }
+
+  static void printStats(std::ostream &out, unsigned numReplaced) {
+    out << "gvn: replaced " << numReplaced << " nodes" << std::endl;
+  }
+
+private:
+  static void enterBlock(ir_node *block, void *env) {
+    auto *pass = static_cast<GvnPass *>(env);
+    pass->scopes.push_back(pass->addedKeys.size());
+    auto nodes = pass->blockNodes.find(block);
+    if (nodes == pass->blockNodes.end()) {
+      return;
+    }
+    for (auto node : nodes->second) {
+      pass->numberNode(node);
+    }
+  }
+
+  static void leaveBlock(ir_node *, void *env) {
+    auto *pass = static_cast<GvnPass *>(env);
+    size_t start = pass->scopes.back();
+    pass->scopes.pop_back();
+    for (size_t i = start; i < pass->addedKeys.size(); ++i) {
+      pass->values.erase(pass->addedKeys[i]);
+    }
+    pass->addedKeys.resize(start);
+  }
+
+  void numberNode(ir_node *node) {
+    ValueKey key;
+    if (!getKey(node, key)) {
+      return;
+    }
+    auto known = values.find(key);
+    if (known == values.end()) {
+      values.insert({key, node});
+      addedKeys.push_back(key);
+      return;
+    }
+    replaceNode(node, known->second);
+  }
+
+  void replaceNode(ir_node *node, ir_node *leader) {
+    if (get_irn_mode(node) == mode_T) {
+      // The memory users stay behind node's own memory input, so everything
+      // between leader and node in the memory chain stays in order. The
+      // other Projs become duplicates of the ones of leader and are numbered
+      // next.
+      foreach_out_edge_safe(node, edge) {
+        ir_node *proj = get_edge_src_irn(edge);
+        if (get_irn_mode(proj) == mode_M) {
+          exchangeWithLink(proj, getMemory(node));
+        } else {
+          set_nodes_block(proj, get_nodes_block(leader));
+        }
+      }
+    }
+    exchangeWithLink(node, leader);
+    ++replaced;
+  }
+
+  static ir_node *getMemory(ir_node *node) {
+    switch (get_irn_opcode(node)) {
+    case iro_Load:
+      return get_Load_mem(node);
+    case iro_Div:
+      return get_Div_mem(node);
+    case iro_Mod:
+      return get_Mod_mem(node);
+    default:
+      return nullptr;
+    }
+  }
+
+  // loads, divisions and modulo don't change memory, skips them in the
+  // memory chain so loads behind them are still found equal
+  static ir_node *skipReadOnly(ir_node *mem) {
+    while (is_Proj(mem) && getMemory(get_Proj_pred(mem)) != nullptr) {
+      mem = getMemory(get_Proj_pred(mem));
+    }
+    return mem;
+  }
+
+  static bool isCommutative(ir_node *node) {
+    return is_Add(node) || is_Mul(node) || is_And(node) || is_Or(node) ||
+           is_Eor(node);
+  }
+
+  bool getKey(ir_node *node, ValueKey &key) {
+    key.opcode = get_irn_opcode(node);
+    key.mode = get_irn_mode(node);
+    key.attr = 0;
+    key.block = nullptr;
+    key.in[0] = key.in[1] = key.in[2] = nullptr;
+
+    switch (get_irn_opcode(node)) {
+    case iro_Const:
+      key.attr = reinterpret_cast<uintptr_t>(get_Const_tarval(node));
+      return true;
+    case iro_Address:
+      key.attr = reinterpret_cast<uintptr_t>(get_Address_entity(node));
+      return true;
+    case iro_Proj:
+      if (key.mode == mode_X) {
+        return false; // control flow is never duplicated
+      }
+      key.attr = get_Proj_num(node);
+      key.in[0] = get_Proj_pred(node);
+      return true;
+    case iro_Cmp:
+      // the backend generates the comparison together with its Cond
+      key.attr = get_Cmp_relation(node);
+      key.block = get_nodes_block(node);
+      key.in[0] = get_Cmp_left(node);
+      key.in[1] = get_Cmp_right(node);
+      return true;
+    case iro_Load:
+      key.attr = reinterpret_cast<uintptr_t>(get_Load_mode(node));
+      key.in[0] = skipReadOnly(get_Load_mem(node));
+      key.in[1] = get_Load_ptr(node);
+      return true;
+    case iro_Div:
+      key.attr = reinterpret_cast<uintptr_t>(get_Div_resmode(node));
+      key.in[0] = skipReadOnly(get_Div_mem(node));
+      key.in[1] = get_Div_left(node);
+      key.in[2] = get_Div_right(node);
+      return true;
+    case iro_Mod:
+      key.attr = reinterpret_cast<uintptr_t>(get_Mod_resmode(node));
+      key.in[0] = skipReadOnly(get_Mod_mem(node));
+      key.in[1] = get_Mod_left(node);
+      key.in[2] = get_Mod_right(node);
+      return true;
+    case iro_Add:
+    case iro_Sub:
+    case iro_Mul:
+    case iro_And:
+    case iro_Or:
+    case iro_Eor:
+    case iro_Shl:
+    case iro_Shr:
+    case iro_Shrs:
+      key.in[0] = get_irn_n(node, 0);
+      key.in[1] = get_irn_n(node, 1);
+      if (isCommutative(node) &&
+          std::less<ir_node *>()(key.in[1], key.in[0])) {
+        std::swap(key.in[0], key.in[1]);
+      }
+      return true;
+    case iro_Minus:
+    case iro_Not:
+    case iro_Conv:
+      key.in[0] = get_irn_n(node, 0);
+      return true;
+    default:
+      return false;
+    }
+  }
+};
+
+#endif // GVN_PASS
@@ -0,0 +1,399 @@
+#ifndef INLINE_PASS
+#define INLINE_PASS
+
+#include "firm_pass.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct CallSite {
+  ir_node *call;
+  ir_graph *callee;
+  // nesting depth of the loops around the call, 0 outside of loops
+  unsigned loopDepth;
+};
+
+// Counts the nodes of a graph and collects its calls of other methods.
+// Constants aren't visited and don't count. Needs the loop info of the graph.
+class CallSiteCollector : public FunctionPass<CallSiteCollector> {
+  unsigned size = 0;
+  bool returns = false;
+  std::vector<CallSite> callSites;
+
+public:
+  CallSiteCollector(ir_graph *firmgraph) : FunctionPass(firmgraph) {}
+
+  void defaultVisitOp(ir_node *) { ++size; }
+
+  void visitCall(ir_node *call) {
+    ++size;
+    ir_graph *callee = get_entity_irg(get_Call_callee(call));
+    if (callee == nullptr) {
+      return; // runtime functions have no graph
+    }
+    ir_loop *loop = get_irn_loop(get_nodes_block(call));
+    callSites.push_back(
+        {call, callee, loop ? static_cast<unsigned>(get_loop_depth(loop)) : 0});
+  }
+
+  void visitReturn(ir_node *) {
+    ++size;
+    returns = true;
+  }
+
+  unsigned getSize() const { return size; }
+  bool hasReturn() const { return returns; }
+  std::vector<CallSite> &getCallSites() { return callSites; }
+};
+
+// Inlines small methods and methods with a single call site into their
+// callers. Recursive methods are never inlined. The graphs are visited
+// callees first, so a callee is inlined with the calls it contains already
+// inlined. Calls inside the inlined bodies are only looked at in the next
+// run of the pass. The growth budget is shared by all runs.
+class InlinePass : public ProgramPass<InlinePass> {
+  // callees up to this size are inlined everywhere, the limit doubles with
+  // every loop level around the call up to maxLoopBonus levels
+  static constexpr unsigned smallCalleeSize = 30;
+  static constexpr unsigned maxLoopBonus = 3;
+  // a callee with a single call site is removed by unused-fn afterwards, so
+  // inlining it doesn't make the program bigger. Without unused-fn it counts
+  // against the budget like any other callee.
+  static constexpr unsigned singleCallSiteSize = 400;
+  // no caller grows beyond this, recursive or not
+  static constexpr unsigned maxCallerSize = 4000;
+  // all runs together may grow the program by half of its size before the
+  // first run, but at least by this much
+  static constexpr unsigned minGrowthBudget = 500;
+
+  struct GraphInfo {
+    unsigned size;
+    bool returns;
+    bool recursive = false;
+    // number of call sites in the program calling this graph
+    unsigned callers = 0;
+    std::vector<CallSite> callSites;
+  };
+  std::unordered_map<ir_graph *, GraphInfo> infos;
+  // graphs ordered callees first, callers of a recursive cycle in any order
+  std::vector<ir_graph *> bottomUp;
+  bool removesUnused;
+  bool budgetComputed = false;
+  unsigned growthBudget = 0;
+  unsigned inlinedCalls = 0;
+
+  // state of the call currently inlined
+  ir_graph *caller = nullptr;
+  ir_node *call = nullptr;
+  ir_node *entryBlock = nullptr;
+  // maps the nodes of the callee to their copies in the caller
+  std::unordered_map<ir_node *, ir_node *> copies;
+  // the callee nodes which have a fresh copy, in contrast to the ones mapped
+  // to existing nodes of the caller
+  std::vector<ir_node *> copied;
+
+public:
+  // removesUnused tells whether unused-fn runs after the pass
+  InlinePass(std::vector<ir_graph *> &graphs, bool removesUnused)
+      : ProgramPass(graphs), removesUnused(removesUnused) {}
+
+  void before() {
+    // the graphs changed since the last run
+    infos.clear();
+    bottomUp.clear();
+    unsigned totalSize = 0;
+    for (auto g : allGraphs) {
+      assure_loopinfo(g);
+      CallSiteCollector collector(g);
+      collector.run();
+      auto &info = infos[g];
+      info.size = collector.getSize();
+      info.returns = collector.hasReturn();
+      info.callSites = std::move(collector.getCallSites());
+      totalSize += info.size;
+    }
+    for (auto &entry : infos) {
+      for (auto &site : entry.second.callSites) {
+        auto callee = infos.find(site.callee);
+        if (callee != infos.end()) {
+          ++callee->second.callers;
+        }
+      }
+    }
+    if (!budgetComputed) {
+      growthBudget =
+          totalSize / 2 > minGrowthBudget ? totalSize / 2 : minGrowthBudget;
+      budgetComputed = true;
+    }
+    findRecursion();
+  }
+
+  void initWorkList() {
+    for (auto g : bottomUp) {
+      enqueue(g);
+    }
+  }
+
+  void visitMethod(ir_graph *graph) {
+    auto &info = infos[graph];
+    bool inlinedAny = false;
+    for (auto &site : info.callSites) {
+      auto callee = infos.find(site.callee);
+      if (callee == infos.end() || !shouldInline(info, site, callee->second)) {
+        continue;
+      }
+      inlineCall(graph, site);
+      info.size += callee->second.size;
+      --callee->second.callers;
+      ++inlinedCalls;
+      inlinedAny = true;
+    }
+    if (inlinedAny) {
+      // the loop info and dominance of the caller are outdated now
+      confirm_irg_properties(graph, IR_GRAPH_PROPERTIES_NONE);
+      changed = true;
+    }
+  }
+
+  unsigned getNumChanges() const { return inlinedCalls; }
+
+  static void printStats(std::ostream &out, unsigned numInlined) {
+    out << "inline: inlined " << numInlined << " calls" << std::endl;
+  }
+
+private:
+  bool shouldInline(const GraphInfo &callerInfo, const CallSite &site,
+                    const GraphInfo &calleeInfo) {
+    // a callee without return never gets back to the call, nothing to gain
+    if (calleeInfo.recursive || !calleeInfo.returns) {
+      return false;
+    }
+    if (callerInfo.size + calleeInfo.size > maxCallerSize) {
+      return false;
+    }
+    if (removesUnused && calleeInfo.callers == 1 &&
+        calleeInfo.size <= singleCallSiteSize) {
+      return true;
+    }
+    unsigned loopBonus =
+        site.loopDepth < maxLoopBonus ? site.loopDepth : maxLoopBonus;
+    if (calleeInfo.size > smallCalleeSize << loopBonus ||
+        calleeInfo.size > growthBudget) {
+      return false;
+    }
+    growthBudget -= calleeInfo.size;
+    return true;
+  }
+
+  // Tarjan's algorithm, iteratively since call chains can be long. Emits the
+  // strongly connected components of the call graph callees first and marks
+  // the graphs in cycles and the ones calling themselves as recursive.
+  void findRecursion() {
+    struct Frame {
+      ir_graph *graph;
+      size_t nextCallSite;
+    };
+    std::unordered_map<ir_graph *, unsigned> index, lowLink;
+    std::vector<ir_graph *> stack;
+    std::unordered_set<ir_graph *> onStack;
+    std::vector<Frame> frames;
+    unsigned nextIndex = 0;
+
+    for (auto root : allGraphs) {
+      if (index.count(root)) {
+        continue;
+      }
+      index[root] = lowLink[root] = nextIndex++;
+      stack.push_back(root);
+      onStack.insert(root);
+      frames.push_back({root, 0});
+
+      while (!frames.empty()) {
+        auto &frame = frames.back();
+        auto &info = infos[frame.graph];
+        if (frame.nextCallSite < info.callSites.size()) {
+          ir_graph *callee = info.callSites[frame.nextCallSite++].callee;
+          if (!infos.count(callee)) {
+            continue;
+          }
+          if (callee == frame.graph) {
+            info.recursive = true;
+          }
+          if (!index.count(callee)) {
+            index[callee] = lowLink[callee] = nextIndex++;
+            stack.push_back(callee);
+            onStack.insert(callee);
+            frames.push_back({callee, 0}); // invalidates frame
+          } else if (onStack.count(callee)) {
+            lowLink[frame.graph] =
+                std::min(lowLink[frame.graph], index[callee]);
+          }
+          continue;
+        }
+
+        ir_graph *graph = frame.graph;
+        frames.pop_back();
+        if (!frames.empty()) {
+          ir_graph *parent = frames.back().graph;
+          lowLink[parent] = std::min(lowLink[parent], lowLink[graph]);
+        }
+        if (lowLink[graph] != index[graph]) {
+          continue;
+        }
+        // graph is the root of a component, which is on top of the stack
+        size_t first = stack.size();
+        while (stack[--first] != graph) {
+        }
+        bool cycle = stack.size() - first > 1;
+        for (size_t i = first; i < stack.size(); ++i) {
+          infos[stack[i]].recursive |= cycle;
+          onStack.erase(stack[i]);
+          bottomUp.push_back(stack[i]);
+        }
+        stack.resize(first);
+      }
+    }
+  }
+
+  static void copyNodeWalker(ir_node *node, void *env) {
+    static_cast<InlinePass *>(env)->copyNode(node);
+  }
+
+  // Maps node of the callee to a node of the caller. The Start node and its
+  // Projs become the memory and arguments of the call, the start block
+  // becomes the block of the call, which jumps to the copy of the first
+  // block of the body. Returns and the end are left out, they
+  // are connected to the rest of the caller in inlineCall.
+  void copyNode(ir_node *node) {
+    ir_graph *callee = get_irn_irg(node);
+    if (node == get_irg_end(callee) || node == get_irg_end_block(callee) ||
+        is_Start(node) || is_Return(node)) {
+      return;
+    }
+    if (node == get_irg_start_block(callee)) {
+      copies[node] = entryBlock;
+      return;
+    }
+    if (node == get_irg_no_mem(callee)) {
+      copies[node] = get_irg_no_mem(caller);
+      return;
+    }
+    if (is_Proj(node) && is_Start(get_Proj_pred(node))) {
+      switch (get_Proj_num(node)) {
+      case pn_Start_M:
+        copies[node] = get_Call_mem(call);
+        break;
+      case pn_Start_P_frame_base:
+        copies[node] = get_irg_frame(caller);
+        break;
+      case pn_Start_X_initial_exec:
+        copies[node] = new_r_Jmp(entryBlock);
+        break;
+      default:
+        break; // the argument tuple, only used by the argument Projs
+      }
+      return;
+    }
+    if (is_Proj(node) && get_Proj_pred(node) == get_irg_args(callee)) {
+      copies[node] = get_Call_param(call, get_Proj_num(node));
+      return;
+    }
+    copies[node] = irn_copy_into_irg(node, caller);
+    copied.push_back(node);
+  }
+
+  void inlineCall(ir_graph *graph, const CallSite &site) {
+    ir_graph *callee = site.callee;
+    caller = graph;
+    call = site.call;
+
+    // the call and everything it depends on stay in the upper part of its
+    // block, the inlined code goes between the two parts
+    edges_activate(caller);
+    ir_node *continueBlock = part_block_edges(call);
+    entryBlock = get_nodes_block(call);
+    edges_deactivate(caller);
+
+    copies.clear();
+    copied.clear();
+    irg_walk_graph(callee, copyNodeWalker, nullptr, this);
+
+    ir_node *calleeStartBlock = get_irg_start_block(callee);
+    ir_node *startBlock = get_irg_start_block(caller);
+    for (auto node : copied) {
+      ir_node *copy = copies[node];
+      if (!is_Block(node)) {
+        // constants and the like have to stay in the start block
+        bool startBlockPlaced = get_irn_arity(node) == 0 && !is_Jmp(node) &&
+                                get_nodes_block(node) == calleeStartBlock;
+        set_nodes_block(copy, startBlockPlaced
+                                  ? startBlock
+                                  : copies.at(get_nodes_block(node)));
+      }
+      for (int i = 0; i < get_irn_arity(node); ++i) {
+        set_irn_n(copy, i, copies.at(get_irn_n(node, i)));
+      }
+    }
+
+    ir_node *calleeEnd = get_irg_end(callee);
+    for (int i = 0; i < get_End_n_keepalives(calleeEnd); ++i) {
+      ir_node *keepAlive = get_End_keepalive(calleeEnd, i);
+      if (!is_Bad(keepAlive)) {
+        add_End_keepalive(get_irg_end(caller), copies.at(keepAlive));
+      }
+    }
+
+    // every Return jumps to the lower part of the call block instead
+    std::vector<ir_node *> jumps, mems, results;
+    ir_node *endBlock = get_irg_end_block(callee);
+    for (int i = 0; i < get_Block_n_cfgpreds(endBlock); ++i) {
+      ir_node *ret = get_Block_cfgpred(endBlock, i);
+      if (!is_Return(ret)) {
+        continue;
+      }
+      jumps.push_back(new_r_Jmp(copies.at(get_nodes_block(ret))));
+      mems.push_back(copies.at(get_Return_mem(ret)));
+      if (get_Return_n_ress(ret) > 0) {
+        results.push_back(copies.at(get_Return_res(ret, 0)));
+      }
+    }
+    set_irn_in(continueBlock, jumps.size(), jumps.data());
+    ir_node *mem = mergeValues(continueBlock, mems, mode_M);
+    ir_node *result =
+        results.empty()
+            ? nullptr
+            : mergeValues(continueBlock, results, get_irn_mode(results[0]));
+
+    edges_activate(caller);
+    foreach_out_edge_safe(call, edge) {
+      ir_node *proj = get_edge_src_irn(edge);
+      switch (get_Proj_num(proj)) {
+      case pn_Call_M:
+        exchange(proj, mem);
+        break;
+      case pn_Call_T_result:
+        // MiniJava methods have at most one result
+        foreach_out_edge_safe(proj, resultEdge) {
+          exchange(get_edge_src_irn(resultEdge), result);
+        }
+        break;
+      default:
+        break; // calls of MiniJava methods don't throw
+      }
+    }
+    edges_deactivate(caller);
+  }
+
+  ir_node *mergeValues(ir_node *block, std::vector<ir_node *> &values,
+                       ir_mode *mode) {
+    if (values.size() == 1) {
+      return values[0];
+    }
+    return new_r_Phi(block, values.size(), values.data(), mode);
+  }
+};
+
+#endif // INLINE_PASS
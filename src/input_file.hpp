@@ -31,6 +31,11 @@
 #include <istream>
 #include <memory>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "error.hpp"
 
 class InputFile {
@@ -43,15 +48,22 @@ public:
     fileName = std::move(o.fileName);
     istream = o.istream;
     ownsStream = o.ownsStream;
+    mappedData = o.mappedData;
+    mappedSize = o.mappedSize;
 
     o.istream = nullptr;
     o.ownsStream = false;
+    o.mappedData = nullptr;
+    o.mappedSize = 0;
   };
 
   ~InputFile() {
     if (ownsStream) {
       delete istream;
     }
+    if (mappedSize > 0) {
+      ::munmap(const_cast<char *>(mappedData), mappedSize);
+    }
   }
 
   const std::string &getFilename() const { return fileName; }
@@ -69,10 +81,49 @@ public:
     return istream;
   }
 
+  /// maps the whole file read-only into memory; returns false if the input
+  /// can't be mapped (explicit stream, pipe, ...), use getStream() then
+  bool mapFile() const {
+    if (mappedData) {
+      return true;
+    }
+    if (istream) {
+      return false;
+    }
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false; // let getStream() report the error
+    }
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+      ::close(fd);
+      return false;
+    }
+    if (fileStat.st_size == 0) { // mmap can't map empty files
+      ::close(fd);
+      mappedData = "";
+      return true;
+    }
+    void *data = ::mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+    ::madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+    mappedData = static_cast<const char *>(data);
+    mappedSize = fileStat.st_size;
+    return true;
+  }
+
+  const char *getMappedData() const { return mappedData; }
+  size_t getMappedSize() const { return mappedSize; }
+
 private:
   std::string fileName;
   mutable std::istream *istream;
   mutable bool ownsStream = false;
+  mutable const char *mappedData = nullptr;
+  mutable size_t mappedSize = 0;
 };
 
 #endif // INPUT_FILE_H
@@ -26,67 +26,168 @@
 
 #include "lexer.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "lexer_dfa.hpp"
 #include "util.hpp"
 
-std::unordered_map<std::string, Token::Type> Lexer::identifierTokens{
+namespace {
+// keywords and reserved words are recognized with a perfect hash which is
+// generated at compile time
+
+struct Keyword {
+  const char *word;
+  size_t length;
+  Token::Type type;
+};
+
+constexpr size_t constLength(const char *str) {
+  size_t len = 0;
+  while (str[len])
+    ++len;
+  return len;
+}
+
+#define KEYWORD(word, type) {word, constLength(word), Token::Type::type}
+constexpr Keyword keywords[] = {
     // keywords
-    {"boolean", Token::Type::Boolean},
-    {"class", Token::Type::Class},
-    {"else", Token::Type::Else},
-    {"false", Token::Type::False},
-    {"if", Token::Type::If},
-    {"int", Token::Type::Int},
-    {"new", Token::Type::New},
-    {"null", Token::Type::Null},
-    {"public", Token::Type::Public},
-    {"return", Token::Type::Return},
-    {"static", Token::Type::Static},
-    {"this", Token::Type::This},
-    {"true", Token::Type::True},
-    {"void", Token::Type::Void},
-    {"while", Token::Type::While},
+    KEYWORD("boolean", Boolean),
+    KEYWORD("class", Class),
+    KEYWORD("else", Else),
+    KEYWORD("false", False),
+    KEYWORD("if", If),
+    KEYWORD("int", Int),
+    KEYWORD("new", New),
+    KEYWORD("null", Null),
+    KEYWORD("public", Public),
+    KEYWORD("return", Return),
+    KEYWORD("static", Static),
+    KEYWORD("this", This),
+    KEYWORD("true", True),
+    KEYWORD("void", Void),
+    KEYWORD("while", While),
 
     // reserved but unused keywords:
-    {"abstract", Token::Type::ReservedKeyword},
-    {"assert", Token::Type::ReservedKeyword},
-    {"break", Token::Type::ReservedKeyword},
-    {"byte", Token::Type::ReservedKeyword},
-    {"case", Token::Type::ReservedKeyword},
-    {"catch", Token::Type::ReservedKeyword},
-    {"char", Token::Type::ReservedKeyword},
-    {"const", Token::Type::ReservedKeyword},
-    {"continue", Token::Type::ReservedKeyword},
-    {"default", Token::Type::ReservedKeyword},
-    {"double", Token::Type::ReservedKeyword},
-    {"do", Token::Type::ReservedKeyword},
-    {"enum", Token::Type::ReservedKeyword},
-    {"extends", Token::Type::ReservedKeyword},
-    {"finally", Token::Type::ReservedKeyword},
-    {"final", Token::Type::ReservedKeyword},
-    {"float", Token::Type::ReservedKeyword},
-    {"for", Token::Type::ReservedKeyword},
-    {"goto", Token::Type::ReservedKeyword},
-    {"implements", Token::Type::ReservedKeyword},
-    {"import", Token::Type::ReservedKeyword},
-    {"instanceof", Token::Type::ReservedKeyword},
-    {"interface", Token::Type::ReservedKeyword},
-    {"long", Token::Type::ReservedKeyword},
-    {"native", Token::Type::ReservedKeyword},
-    {"package", Token::Type::ReservedKeyword},
-    {"private", Token::Type::ReservedKeyword},
-    {"protected", Token::Type::ReservedKeyword},
-    {"short", Token::Type::ReservedKeyword},
-    {"strictfp", Token::Type::ReservedKeyword},
-    {"super", Token::Type::ReservedKeyword},
-    {"switch", Token::Type::ReservedKeyword},
-    {"synchronized", Token::Type::ReservedKeyword},
-    {"throws", Token::Type::ReservedKeyword},
-    {"throw", Token::Type::ReservedKeyword},
-    {"transient", Token::Type::ReservedKeyword},
-    {"try", Token::Type::ReservedKeyword},
-    {"volatile", Token::Type::ReservedKeyword},
+    KEYWORD("abstract", ReservedKeyword),
+    KEYWORD("assert", ReservedKeyword),
+    KEYWORD("break", ReservedKeyword),
+    KEYWORD("byte", ReservedKeyword),
+    KEYWORD("case", ReservedKeyword),
+    KEYWORD("catch", ReservedKeyword),
+    KEYWORD("char", ReservedKeyword),
+    KEYWORD("const", ReservedKeyword),
+    KEYWORD("continue", ReservedKeyword),
+    KEYWORD("default", ReservedKeyword),
+    KEYWORD("double", ReservedKeyword),
+    KEYWORD("do", ReservedKeyword),
+    KEYWORD("enum", ReservedKeyword),
+    KEYWORD("extends", ReservedKeyword),
+    KEYWORD("finally", ReservedKeyword),
+    KEYWORD("final", ReservedKeyword),
+    KEYWORD("float", ReservedKeyword),
+    KEYWORD("for", ReservedKeyword),
+    KEYWORD("goto", ReservedKeyword),
+    KEYWORD("implements", ReservedKeyword),
+    KEYWORD("import", ReservedKeyword),
+    KEYWORD("instanceof", ReservedKeyword),
+    KEYWORD("interface", ReservedKeyword),
+    KEYWORD("long", ReservedKeyword),
+    KEYWORD("native", ReservedKeyword),
+    KEYWORD("package", ReservedKeyword),
+    KEYWORD("private", ReservedKeyword),
+    KEYWORD("protected", ReservedKeyword),
+    KEYWORD("short", ReservedKeyword),
+    KEYWORD("strictfp", ReservedKeyword),
+    KEYWORD("super", ReservedKeyword),
+    KEYWORD("switch", ReservedKeyword),
+    KEYWORD("synchronized", ReservedKeyword),
+    KEYWORD("throws", ReservedKeyword),
+    KEYWORD("throw", ReservedKeyword),
+    KEYWORD("transient", ReservedKeyword),
+    KEYWORD("try", ReservedKeyword),
+    KEYWORD("volatile", ReservedKeyword),
+};
+#undef KEYWORD
+
+constexpr size_t keywordMinLength = 2, keywordMaxLength = 12;
+constexpr size_t keywordTableBits = 8;
+constexpr size_t keywordTableSize = 1 << keywordTableBits;
+
+// only looks at the first two chars, the last char and the length. Callers
+// have to ensure keywordMinLength <= length
+constexpr uint32_t toByte(char c) {
+  return static_cast<uint32_t>(static_cast<unsigned char>(c));
+}
+
+constexpr uint32_t keywordHash(const char *str, size_t length, uint32_t seed) {
+  uint32_t key = toByte(str[0]) | toByte(str[1]) << 8 |
+                 toByte(str[length - 1]) << 16 |
+                 static_cast<uint32_t>(length) << 24;
+  return (key * seed) >> (32 - keywordTableBits);
+}
+
+constexpr bool isPerfectSeed(uint32_t seed) {
+  bool used[keywordTableSize] = {};
+  for (const Keyword &kw : keywords) {
+    uint32_t hash = keywordHash(kw.word, kw.length, seed);
+    if (used[hash])
+      return false;
+    used[hash] = true;
+  }
+  return true;
+}
+
+constexpr uint32_t findPerfectSeed() {
+  for (uint32_t seed = 0x9e3779b1; seed != 0; seed += 2) {
+    if (isPerfectSeed(seed))
+      return seed;
+  }
+  return 0;
+}
+
+constexpr uint32_t keywordSeed = findPerfectSeed();
+static_assert(keywordSeed != 0, "no perfect hash seed for the keywords");
+
+struct KeywordTable {
+  // index into 'keywords' or -1 for empty slots
+  int8_t slots[keywordTableSize];
 };
 
+constexpr KeywordTable makeKeywordTable() {
+  KeywordTable table{};
+  for (size_t i = 0; i < keywordTableSize; ++i)
+    table.slots[i] = -1;
+  for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); ++i) {
+    const Keyword &kw = keywords[i];
+    table.slots[keywordHash(kw.word, kw.length, keywordSeed)] = i;
+  }
+  return table;
+}
+
+constexpr KeywordTable keywordTable = makeKeywordTable();
+}
+
+/// returns the keyword type for str[0, length) or Token::Type::Identifier
+static Token::Type lookupKeyword(const char *str, size_t length) {
+  if (length < keywordMinLength || length > keywordMaxLength) {
+    return Token::Type::Identifier;
+  }
+  int8_t slot = keywordTable.slots[keywordHash(str, length, keywordSeed)];
+  if (slot < 0) {
+    return Token::Type::Identifier;
+  }
+  const Keyword &kw = keywords[slot];
+  if (kw.length != length || std::memcmp(kw.word, str, length) != 0) {
+    return Token::Type::Identifier;
+  }
+  return kw.type;
+}
+
 bool Lexer::tokenNameNeedsQuotes(Token::Type type) {
   switch (type) {
   case Token::Type::Eof:
@@ -242,6 +343,17 @@ const char *Lexer::getTokenName(Token::Type type) {
   }
 }
 
+const char *Token::getFixedSpelling(Type type) {
+  switch (type) {
+  case Type::none:
+    return "";
+  case Type::Eof:
+    return "EOF";
+  default:
+    return Lexer::getTokenName(type);
+  }
+}
+
 Token::Type Lexer::getSingleCharOpToken(int c) {
   switch (c) {
   case '(':
@@ -274,101 +386,62 @@ Token::Type Lexer::getSingleCharOpToken(int c) {
 }
 
 int Lexer::nextChar() {
-  static enum { normal, cr, lf, crlf } lineState = normal;
-
   if (lastChar == '\t') {
     ++column; // add extra space after tab, since they are printes as two spaces
   }
+  int prevChar = lastChar;
 
   if (!streamIsEof && nextCharPos == curBufferSize) {
     readIntoBuffer();
   }
 
-  lastChar = static_cast<int>(buffer[nextCharPos++]);
-
-  // the following is to identify different line breaks correctly
-  // (mixture of CR and LF)
-  switch (lineState) {
-  case normal: {
-    switch (lastChar) {
-    case '\r':
-      lineState = cr;
-      break;
-    case '\n':
-      lineState = lf;
-      break;
-    default:
-      // lineState = normal;
-      break;
-    }
-    break;
-  }
-  case cr: {
-    switch (lastChar) {
-    case '\r':
-      // lineState = cr;
-      goto newline;
-    case '\n':
-      lineState = crlf;
-      break;
-    default:
-      lineState = normal;
-      goto newline;
-    }
-    break;
-  }
-  case lf: {
-    switch (lastChar) {
-    case '\r':
-      lineState = cr;
-      goto newline;
-    case '\n':
-      // lineState = lf;
-      goto newline;
-    default:
-      lineState = normal;
-      goto newline;
-    }
-    break;
-  }
-  case crlf: {
-    switch (lastChar) {
-    case '\r':
-      lineState = cr;
-      goto newline;
-    case '\n':
-      lineState = lf;
-      goto newline;
-    default:
-      lineState = normal;
-      goto newline;
-    }
-    break;
+  if (likely(nextCharPos < curBufferSize)) {
+    lastChar = static_cast<int>(buffer[nextCharPos]);
+  } else {
+    lastChar = EOF;
   }
-  newline:
+  ++nextCharPos;
+
+  // line breaks are LF, CR LF or a lone CR (mixtures included); the new line
+  // starts at the first char after the line break
+  if (prevChar == '\n' || (prevChar == '\r' && lastChar != '\n')) {
     column = 1;
     ++line;
-
-    lineStartFileOffsets.push_back(bufferStartOffset + nextCharPos -
-                                   static_cast<std::streamoff>(1));
-
     return lastChar;
-  } // switch end
+  }
 
   ++column;
   return lastChar;
 }
 
-std::string Lexer::getCurrentLineFromInput(int lineNr) {
-  int oldPos = input.tellg();
-  input.clear(); // need to clear potential eof bit before seek
-  input.seekg(lineStartFileOffsets.at(lineNr - 1));
+/// same as calling nextChar() 'count' times, but the chars have to be in the
+/// current buffer
+void Lexer::skipChars(size_t count) {
+  assert(nextCharPos + count <= curBufferSize);
+  if (count == 0) {
+    return;
+  }
+  // lastChar is always the char before nextCharPos in the buffer
+  const char *passed = buffer + nextCharPos - 1;
+  LexerScan::LineInfo info;
+  scanKernels.scanLines(passed, count, info);
+  if (info.lines > 0) {
+    line += info.lines;
+    column = 1 + (count - info.lastBreak - 1) + info.tabs;
+  } else {
+    column += count + info.tabs;
+  }
+  nextCharPos += count;
+  lastChar = static_cast<int>(buffer[nextCharPos - 1]);
+}
+
+template <typename GetCharFn>
+static std::string formatInputLine(GetCharFn getChar) {
   std::string res;
-  int c = input.get();
+  int c = getChar();
   constexpr int maxLineLength = 1024;
   int lineLength = 0;
-  while (c != '\r' && c != '\n' && input.good() &&
-         ++lineLength < maxLineLength) {
+  while (c != '\r' && c != '\n' && c != EOF && ++lineLength < maxLineLength) {
     if (c == '\t') {
       res += "  "; // use 2 spaces for tabs
     } else if (!std::isprint(c)) {
@@ -376,16 +449,88 @@ std::string Lexer::getCurrentLineFromInput(int lineNr) {
     } else {
       res.push_back(c);
     }
-    c = input.get();
+    c = getChar();
   }
   if (lineLength == maxLineLength) {
     res += "...";
   }
-  input.seekg(oldPos);
   return res.empty() ? co::color_output(co::cyan, co::normal)("\\empty-line")
                      : res;
 }
 
+void Lexer::buildLineIndex() {
+  lineStartFileOffsets.push_back(0);
+  // the kernels need one char of lookahead, so the very last char of the
+  // input is checked separately
+  auto addLastChar = [this](char last, std::streamoff offset) {
+    if (last == '\n' || last == '\r') {
+      lineStartFileOffsets.push_back(offset + 1);
+    }
+  };
+
+  if (!input) {
+    if (curBufferSize > 0) {
+      scanKernels.findLineStarts(buffer, curBufferSize - 1,
+                                 lineStartFileOffsets, 0);
+      addLastChar(buffer[curBufferSize - 1], curBufferSize - 1);
+    }
+    return;
+  }
+
+  std::streamoff oldPos = input->tellg();
+  input->clear(); // need to clear potential eof bit before seek
+  input->seekg(0);
+  constexpr size_t blockSize = 64 * 1024;
+  std::vector<char> block(blockSize + 1);
+  std::streamoff blockStart = 0;
+  // the last char of a block is carried over and scanned with the next one
+  size_t carried = 0;
+  while (*input) {
+    input->read(block.data() + carried, blockSize);
+    size_t size = carried + input->gcount();
+    if (size <= carried) {
+      break;
+    }
+    scanKernels.findLineStarts(block.data(), size - 1, lineStartFileOffsets,
+                               blockStart);
+    block[0] = block[size - 1];
+    blockStart += size - 1;
+    carried = 1;
+  }
+  if (carried) {
+    addLastChar(block[0], blockStart);
+  }
+  input->clear();
+  input->seekg(oldPos);
+}
+
+std::string Lexer::getCurrentLineFromInput(int lineNr) {
+  if (lineStartFileOffsets.empty()) {
+    buildLineIndex();
+  }
+  if (static_cast<size_t>(lineNr - 1) >= lineStartFileOffsets.size()) {
+    return formatInputLine([]() { return EOF; });
+  }
+  std::streamoff lineStart = lineStartFileOffsets[lineNr - 1];
+  if (!input) {
+    // memory mapped: just slice the line out of the mapping
+    const char *pos = buffer + lineStart, *end = buffer + curBufferSize;
+    return formatInputLine([&]() {
+      return pos < end ? static_cast<unsigned char>(*pos++) : EOF;
+    });
+  }
+  int oldPos = input->tellg();
+  input->clear(); // need to clear potential eof bit before seek
+  input->seekg(lineStart);
+  std::string res = formatInputLine([this]() {
+    int c = input->get();
+    return input->good() ? c : EOF;
+  });
+  input->clear();
+  input->seekg(oldPos);
+  return res;
+}
+
 static bool isSpace(int c) {
   switch (c) {
   case ' ':
@@ -417,16 +562,21 @@ Token Lexer::readNextToken() {
 
   initToken(); // clear tokenstring, sets line/col to current pos
 
+  if (useDfa) {
+    return readTokenDFA();
+  }
+
   // identifiers [_a-zA-Z][_a-zA-Z0-9]*
   if (isAlphaOrUnderscore(lastChar)) {
-    tokenString = lastChar;
+    appendToToken(lastChar);
     while (isAlphaNumOrUnderscore(nextChar()))
-      tokenString += lastChar;
+      appendToToken(lastChar);
 
-    auto res = identifierTokens.find(tokenString);
-    if (res != identifierTokens.end())
-      return makeToken(res->second);
-    return makeToken(Token::Type::Identifier);
+    auto type = lookupKeyword(tokenString.data(), tokenString.size());
+    if (type == Token::Type::Identifier ||
+        type == Token::Type::ReservedKeyword)
+      return makeSymbolToken(type);
+    return makeToken(type);
   }
 
   // single 0 or leading 1-9:
@@ -469,12 +619,10 @@ Token Lexer::readNextToken() {
   // -----------
   // end of file
   if (isEof()) {
-    tokenString = "EOF";
     return makeToken(Token::Type::Eof);
   }
 
   // remaining single characters as tokens (i.e. operator symbols)
-  tokenString = lastChar;
   Token::Type type = getSingleCharOpToken(lastChar);
   if (unlikely(type == Token::Type::none)) { // illegal character
     invalidCharError(lastChar);
@@ -483,6 +631,273 @@ Token Lexer::readNextToken() {
   return makeToken(type);
 }
 
+bool Lexer::useDfaBackend() {
+  static const bool useDfa = [] {
+    const char *requested = std::getenv("MJC_LEXER");
+    return requested && std::strcmp(requested, "dfa") == 0;
+  }();
+  return useDfa;
+}
+
+Token Lexer::readTokenDFA() {
+  const LexerDFA::Tables &dfa = LexerDFA::tables;
+  unsigned state = dfa.next[LexerDFA::start][static_cast<uint8_t>(lastChar)];
+  if (unlikely(state == LexerDFA::dead)) {
+    if (isEof()) {
+      return makeToken(Token::Type::Eof);
+    }
+    invalidCharError(lastChar);
+  }
+
+  // lastChar is the first char of the token. Tokens never contain line breaks
+  // or tabs, so the position is only updated once per buffer.
+  while (true) {
+    const char *begin = buffer + nextCharPos - 1;
+    const char *end = buffer + curBufferSize;
+    const char *p = begin + 1;
+    unsigned nextState;
+    while (p < end && (nextState = dfa.next[state][static_cast<uint8_t>(
+                           *p)]) != LexerDFA::dead) {
+      state = nextState;
+      ++p;
+    }
+    size_t length = p - begin;
+    Token::Type type = dfa.accept[state];
+    if (type == Token::Type::Identifier || type == Token::Type::IntLiteral) {
+      tokenString.append(begin, length);
+      tokenHash =
+          SymbolTable::StringTable::hashString(begin, length, tokenHash);
+    }
+    nextCharPos += length - 1;
+    column += length - 1;
+    lastChar = static_cast<int>(p[-1]);
+    nextChar();
+    if (p < end) {
+      break;
+    }
+    // the buffer was refilled, the token might continue
+    nextState = dfa.next[state][static_cast<uint8_t>(lastChar)];
+    if (nextState == LexerDFA::dead || isEof()) {
+      break;
+    }
+    state = nextState;
+  }
+
+  Token::Type type = dfa.accept[state];
+  if (type == Token::Type::Identifier) {
+    type = lookupKeyword(tokenString.data(), tokenString.size());
+    if (type == Token::Type::Identifier ||
+        type == Token::Type::ReservedKeyword) {
+      return makeSymbolToken(type);
+    }
+    return makeToken(type);
+  }
+  if (type == Token::Type::IntLiteral) {
+    return makeSymbolToken(type);
+  }
+  return makeToken(type);
+}
+
+/// moves to the last whitespace of the current run of whitespaces, but not
+/// beyond the end of the buffer
+void Lexer::skipWhitespaceRun() {
+  const char *cur = buffer + nextCharPos - 1;
+  size_t available = curBufferSize - nextCharPos + 1;
+  if (available < 2 || !isSpace(cur[1])) {
+    return; // single whitespaces are common, don't bother
+  }
+  skipChars(scanKernels.findNonSpace(cur, available) - 1);
+}
+
+/// moves to the start of the next "*/" or to the next invalid char in a
+/// comment, but not beyond the end of the buffer
+void Lexer::skipCommentRun() {
+  const char *cur = buffer + nextCharPos - 1;
+  size_t available = curBufferSize - nextCharPos + 1;
+  size_t end = scanKernels.findCommentEnd(cur, available);
+  skipChars(end < available ? end : available - 1);
+}
+
+TokenBuffer Lexer::readAllTokens() {
+  if (input) {
+    return readAllTokensSequential();
+  }
+  // opt-in, no machine measured so far lexed faster in parallel
+  unsigned numThreads = 0;
+  if (const char *threads = std::getenv("MJC_LEX_THREADS")) {
+    numThreads = std::atoi(threads);
+  }
+  if (numThreads > 1) {
+    return readAllTokensParallel(numThreads);
+  }
+  return readAllTokensSequential();
+}
+
+TokenBuffer Lexer::readAllTokensSequential() {
+  TokenBuffer tokens;
+  if (!input) {
+    // rough guess, avoids most reallocations
+    size_t expectedTokens = curBufferSize / 4;
+    tokens.types.reserve(expectedTokens);
+    tokens.positions.reserve(expectedTokens);
+    tokens.symbols.reserve(expectedTokens);
+  }
+  try {
+    Token t;
+    do {
+      t = readNextToken();
+      tokens.push_back(t);
+    } while (t.type != Token::Type::Eof);
+  } catch (LexError &) {
+    tokens.lexError = std::current_exception();
+  }
+  return tokens;
+}
+
+/// position of the first "ab" in data[from, size) or size
+static size_t findCharPair(const char *data, size_t from, size_t size, char a,
+                           char b) {
+  while (from + 1 < size) {
+    auto found =
+        static_cast<const char *>(std::memchr(data + from, a, size - from - 1));
+    if (!found) {
+      break;
+    }
+    size_t pos = found - data;
+    if (data[pos + 1] == b) {
+      return pos;
+    }
+    from = pos + 1;
+  }
+  return size;
+}
+
+/// Splits the input into at most numChunks parts of roughly the same size.
+/// Every part starts at the beginning of a line outside of comments; since
+/// comments are the only tokens spanning multiple lines the parts can be
+/// lexed independently.
+static std::vector<size_t> findChunkBoundaries(const char *data, size_t size,
+                                               unsigned numChunks) {
+  std::vector<size_t> boundaries{0};
+  size_t pos = 0; // always outside of comments
+  for (unsigned i = 1; i < numChunks; ++i) {
+    size_t target = std::max<size_t>(size / numChunks * i, pos);
+    size_t split = size;
+    while (split == size) {
+      size_t commentStart = findCharPair(data, pos, size, '/', '*');
+      if (target < commentStart) {
+        auto lf = static_cast<const char *>(
+            std::memchr(data + target, '\n', commentStart - target));
+        if (lf) {
+          split = lf - data + 1;
+          break;
+        }
+      }
+      if (commentStart == size) {
+        break;
+      }
+      size_t commentEnd = findCharPair(data, commentStart + 2, size, '*', '/');
+      if (commentEnd == size) {
+        break; // unterminated comment, reported by the last chunk
+      }
+      pos = commentEnd + 2;
+      target = std::max(target, pos);
+    }
+    if (split >= size) {
+      break;
+    }
+    boundaries.push_back(split);
+    pos = split;
+  }
+  boundaries.push_back(size);
+  return boundaries;
+}
+
+TokenBuffer Lexer::readAllTokensParallel(unsigned numThreads) {
+  std::vector<size_t> boundaries =
+      findChunkBoundaries(buffer, curBufferSize, numThreads);
+  size_t numChunks = boundaries.size() - 1;
+
+  struct Chunk {
+    TokenBuffer tokens;
+    int lines;
+  };
+  std::vector<Chunk> chunks(numChunks);
+  std::mutex strTblMutex;
+
+  auto lexChunk = [&](size_t i) {
+    Chunk &chunk = chunks[i];
+    SymbolTable::StringTable chunkStrTbl;
+    Lexer lexer{buffer + boundaries[i], boundaries[i + 1] - boundaries[i],
+                filename, chunkStrTbl};
+    chunk.tokens = lexer.readAllTokensSequential();
+    chunk.lines = lexer.line - 1;
+
+    // move the symbols over to the shared string table, only once per
+    // distinct symbol of this chunk
+    std::unordered_map<const SymbolTable::Symbol *, SymbolTable::Symbol *>
+        symbolMap;
+    {
+      std::lock_guard<std::mutex> lock(strTblMutex);
+      chunkStrTbl.forEachSymbol(
+          [&](SymbolTable::Symbol &sym, SymbolTable::StringTable::Hash hash) {
+            symbolMap[&sym] =
+                &strTbl.findOrInsert(sym.name.data(), sym.name.size(), hash);
+          });
+    }
+    for (auto &sym : chunk.tokens.symbols) {
+      if (sym) {
+        sym = symbolMap[sym];
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < numChunks; ++i) {
+    workers.emplace_back(lexChunk, i);
+  }
+  lexChunk(0);
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  // stitch the chunks together: the first chunk with a lexer error is the
+  // last one used, all chunks but the last end with a line break and Eof
+  TokenBuffer tokens;
+  int lineOffset = 0;
+  for (size_t i = 0; i < numChunks; ++i) {
+    Chunk &chunk = chunks[i];
+    bool isLast = chunk.tokens.lexError || i == numChunks - 1;
+    size_t count = isLast ? chunk.tokens.size() : chunk.tokens.size() - 1;
+    auto &src = chunk.tokens;
+    tokens.types.insert(tokens.types.end(), src.types.begin(),
+                        src.types.begin() + count);
+    tokens.symbols.insert(tokens.symbols.end(), src.symbols.begin(),
+                          src.symbols.begin() + count);
+    for (size_t t = 0; t < count; ++t) {
+      TokenPos pos = src.positions[t];
+      tokens.positions.emplace_back(pos.line + lineOffset, pos.col);
+    }
+
+    if (chunk.tokens.lexError) {
+      try {
+        std::rethrow_exception(chunk.tokens.lexError);
+      } catch (LexError &e) {
+        tokens.lexError = std::make_exception_ptr(
+            LexError(e.filename, e.line + lineOffset, e.col, e.message,
+                     e.errorLine));
+      }
+    }
+    if (isLast) {
+      break;
+    }
+    lineOffset += chunk.lines;
+    // free memory early
+    chunk = Chunk();
+  }
+  return tokens;
+}
+
 /// returns true if char before last char was '/' (not from comment)
 bool Lexer::skipCommentsAndWhitespaces() {
   while (true) {
@@ -493,6 +908,7 @@ bool Lexer::skipCommentsAndWhitespaces() {
       if (nextChar() == '*') { // multi line comment
         nextChar();
         while (likely(!isEof())) {
+          skipCommentRun();
           if (unlikely(lastChar & 0b1000'0000)) {
             invalidCharError(lastChar);
           }
@@ -517,6 +933,7 @@ bool Lexer::skipCommentsAndWhitespaces() {
     case '\t':
       // skip all whitespaces
       do {
+        skipWhitespaceRun();
         nextChar();
       } while (isSpace(lastChar));
       break;
@@ -527,10 +944,9 @@ bool Lexer::skipCommentsAndWhitespaces() {
 }
 
 Token Lexer::readSlashFromSecondCharOn() { // read '/' '/=' '/*'
-  tokenString = '/';
   // character '/' was already next and lastChar points to the next char
   if (lastChar == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::SlashEq);
   } else {
     return makeToken(Token::Type::Slash);
@@ -538,70 +954,65 @@ Token Lexer::readSlashFromSecondCharOn() { // read '/' '/=' '/*'
 }
 
 Token Lexer::readDecNumber() { // read '0|[1-9][0-9]*'
-  tokenString = lastChar;
+  appendToToken(lastChar);
   if ('0' == lastChar) {
     nextChar();
-    return makeToken(Token::Type::IntLiteral);
+    return makeSymbolToken(Token::Type::IntLiteral);
   }
   while (isDigit(nextChar()))
-    tokenString += lastChar;
-  return makeToken(Token::Type::IntLiteral);
+    appendToToken(lastChar);
+  return makeSymbolToken(Token::Type::IntLiteral);
 }
 
 Token Lexer::readStar() { // read '*' '*='
-  tokenString = '*';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::StarEq);
   }
   return makeToken(Token::Type::Star);
 }
 
 Token Lexer::readPercent() { // read '%' '%='
-  tokenString = '%';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::PercentEq);
   }
   return makeToken(Token::Type::Percent);
 }
 
 Token Lexer::readPlus() { // read '+' '++' '+='
-  tokenString = '+';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::PlusEq);
   }
   if (lastChar == '+') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::PlusPlus);
   }
   return makeToken(Token::Type::Plus);
 }
 
 Token Lexer::readMinus() { // read '-' '--' '-='
-  tokenString = '-';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::MinusEq);
   }
   if (lastChar == '-') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::MinusMinus);
   }
   return makeToken(Token::Type::Minus);
 }
 
 Token Lexer::readLT() { // read '<' '<=' '<<' '<<='
-  tokenString = '<';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::LtEq);
   }
   if (lastChar == '<') {
-    appendAndNext();
+    nextChar();
     if (lastChar == '=') {
-      appendAndNext();
+      nextChar();
       return makeToken(Token::Type::LtLtEq);
     }
     return makeToken(Token::Type::LtLt);
@@ -610,21 +1021,20 @@ Token Lexer::readLT() { // read '<' '<=' '<<' '<<='
 }
 
 Token Lexer::readGT() { // read '>' '>=' '>>' '>>=' '>>>' '>>>='
-  tokenString = '>';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::GtEq);
   }
   if (lastChar == '>') {
-    appendAndNext();
+    nextChar();
     if (lastChar == '=') {
-      appendAndNext();
+      nextChar();
       return makeToken(Token::Type::GtGtEq);
     }
     if (lastChar == '>') {
-      appendAndNext();
+      nextChar();
       if (lastChar == '=') {
-        appendAndNext();
+        nextChar();
         return makeToken(Token::Type::GtGtGtEq);
       }
       return makeToken(Token::Type::GtGtGt);
@@ -635,44 +1045,40 @@ Token Lexer::readGT() { // read '>' '>=' '>>' '>>=' '>>>' '>>>='
 }
 
 Token Lexer::readEq() { // read '=' '=='
-  tokenString = '=';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::EqEq);
   }
   return makeToken(Token::Type::Eq);
 }
 
 Token Lexer::readBang() { // read '!' '!='
-  tokenString = '!';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::BangEq);
   }
   return makeToken(Token::Type::Bang);
 }
 
 Token Lexer::readAmp() { // read '&' '&&' '&='
-  tokenString = '&';
   if (nextChar() == '&') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::AmpAmp);
   }
   if (lastChar == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::AmpEq);
   }
   return makeToken(Token::Type::Amp);
 }
 
 Token Lexer::readVBar() { // read '|' '||' '|='
-  tokenString = '|';
   if (nextChar() == '|') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::VBarVBar);
   }
   if (lastChar == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::VBarEq);
   }
   return makeToken(Token::Type::VBar);
@@ -681,9 +1087,8 @@ Token Lexer::readVBar() { // read '|' '||' '|='
 // Token Lexer::readTilde() { error("not implemented");}
 
 Token Lexer::readCaret() { // read '^' '^='
-  tokenString = '^';
   if (nextChar() == '=') {
-    appendAndNext();
+    nextChar();
     return makeToken(Token::Type::CaretEq);
   }
   return makeToken(Token::Type::Caret);
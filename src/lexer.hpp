@@ -29,14 +29,16 @@
 
 #include <cassert>
 #include <cstring> // for std::strerror
-#include <deque>
+#include <exception>
 #include <string>
-#include <unordered_map>
+#include <type_traits>
 #include <vector>
 using namespace std::string_literals;
 
 #include "error.hpp"
 #include "input_file.hpp"
+#include "lexer_scan.hpp"
+#include "symboltable.hpp"
 #include "util.hpp"
 
 struct TokenPos {
@@ -189,40 +191,35 @@ struct Token {
   // Members
   Type type;
   TokenPos pos;
-  std::string str;
+  // interned spelling, only set for identifiers, integer literals and
+  // reserved keywords. All other tokens have a fixed spelling.
+  SymbolTable::Symbol *sym;
 
   // Operations
-  Token() : Token(Type::none, {}, "") {}
-  Token(Type type) : Token(type, {}, "<?>") {}
+  Token() : type(Type::none), sym(nullptr) {}
+  Token(Type type, TokenPos pos, SymbolTable::Symbol *sym = nullptr)
+      : type(type), pos(pos), sym(sym) {}
 
-  Token(Type type, TokenPos pos, std::string tokenString)
-      : type(type), pos(pos), str(std::move(tokenString)) {}
-
-  Token(const Token &o) : type(o.type), pos(o.pos), str(o.str) {}
-  Token(Token &&o) : type(o.type), pos(o.pos), str(std::move(o.str)) {}
-
-  Token &operator=(const Token &o) = default;
-
-  Token &operator=(Token &&o) {
-    type = o.type;
-    pos = o.pos;
-    str = std::move(o.str);
-    return *this;
+  bool operator==(const Token &o) const {
+    return type == o.type && pos == o.pos && sym == o.sym;
   }
 
-  bool operator==(const Token &o) const {
-    return type == o.type && pos == o.pos && str == o.str;
+  static const char *getFixedSpelling(Type type);
+
+  std::string str() const { return sym ? sym->name : getFixedSpelling(type); }
+  size_t length() const {
+    return sym ? sym->name.length() : std::strlen(getFixedSpelling(type));
   }
 
   std::string toStr() const {
-    return '<' + str + " at " + std::to_string(pos.line) + ':' +
+    return '<' + str() + " at " + std::to_string(pos.line) + ':' +
            std::to_string(pos.col) + '>';
   }
 
   TokenPos startPos() const { return pos; }
   TokenPos endPos() const {
     TokenPos tmp = pos;
-    tmp.col += str.length() - 1;
+    tmp.col += length() - 1;
     return tmp;
   }
   SourceLocation singleTokenSrcLoc() const { return {startPos(), endPos()}; }
@@ -231,19 +228,22 @@ struct Token {
   friend std::ostream &operator<<(std::ostream &o, const Token &t) {
     switch (t.type) {
     case Type::Identifier:
-      o << "identifier " << t.str;
+      o << "identifier " << t.sym->name;
       break;
     case Type::IntLiteral:
-      o << "integer literal " << t.str;
+      o << "integer literal " << t.sym->name;
       break;
     default:
-      o << t.str;
+      o << t.str();
       break;
     }
     return o;
   }
 };
 
+static_assert(std::is_trivially_copyable<Token>::value,
+              "tokens are passed around by value");
+
 class LexError : public CompilerError {
 public:
   const int line, col;
@@ -280,46 +280,96 @@ public:
   }
 };
 
-class Lexer {
-  static std::unordered_map<std::string, Token::Type> identifierTokens;
+/// all tokens of an input file as structure of arrays, read by
+/// Lexer::readAllTokens()
+class TokenBuffer {
+  friend class Lexer;
+
+  std::vector<Token::Type> types;
+  std::vector<TokenPos> positions;
+  std::vector<SymbolTable::Symbol *> symbols;
+  // set if lexing stopped with an error instead of the Eof token
+  std::exception_ptr lexError;
+
+  void push_back(const Token &t) {
+    types.push_back(t.type);
+    positions.push_back(t.pos);
+    symbols.push_back(t.sym);
+  }
 
-  std::istream &input;
+public:
+  size_t size() const { return types.size(); }
+
+  /// past the end this is the Eof token again, or rethrows the lexer error
+  /// if there was one
+  Token get(size_t idx) const {
+    if (unlikely(idx >= types.size())) {
+      if (lexError) {
+        std::rethrow_exception(lexError);
+      }
+      idx = types.size() - 1;
+    }
+    return {types[idx], positions[idx], symbols[idx]};
+  }
+};
+
+class Lexer {
+  // nullptr if the input file is memory mapped
+  std::istream *input = nullptr;
   std::string filename;
+  SymbolTable::StringTable &strTbl;
+  const LexerScan::Kernels &scanKernels = LexerScan::getKernels();
+  // MJC_LEXER=dfa selects the table driven tokenizer instead of the hand
+  // written one
+  const bool useDfa = useDfaBackend();
 
   int lastChar = 0;
   // 1024 seems to be the sweet spot:
   static constexpr const int maxBufferSize = 1024;
-  // input stream buffer
-  char buffer[maxBufferSize];
-  int nextCharPos = 0;
-  int curBufferSize = 0;
+  // input stream buffer, unused if the input file is memory mapped
+  char streamBuffer[maxBufferSize];
+  // points either to streamBuffer or to the whole mapped input file
+  const char *buffer = streamBuffer;
+  size_t nextCharPos = 0;
+  size_t curBufferSize = 0;
   bool streamIsEof = false;
   std::streamoff bufferStartOffset = 0;
 
   std::string tokenString;
+  // hash of tokenString for the string table, computed while reading it
+  SymbolTable::StringTable::Hash tokenHash;
   int line = 1, column = 0; // column is 0 since constructor calls nextChar()
   int tokenLine, tokenCol;
+  // start offset of every line, only built once an input line is requested
+  // for an error message
   std::vector<std::streamoff> lineStartFileOffsets;
 
-  std::deque<Token> tokenLookahead;
-
   Token::Type getSingleCharOpToken(int c);
 
   int nextChar();
-  void appendAndNext() {
-    tokenString += lastChar;
-    nextChar();
-  }
+  void buildLineIndex();
+  void skipChars(size_t count);
+  inline void skipWhitespaceRun();
+  inline void skipCommentRun();
 
   void initToken() {
     tokenString.clear();
+    tokenHash = SymbolTable::StringTable::emptyHash;
     tokenLine = line;
     tokenCol = column;
   }
 
-  Token makeToken(Token::Type type) {
-    // implicit: make a copy of 'tokenString' to keep the string's buffer
-    return Token(type, {tokenLine, tokenCol}, tokenString);
+  Token makeToken(Token::Type type) { return {type, {tokenLine, tokenCol}}; }
+  void appendToToken(char c) {
+    tokenString += c;
+    tokenHash = SymbolTable::StringTable::hashStep(tokenHash, c);
+  }
+  // for tokens without a fixed spelling; interns 'tokenString'
+  Token makeSymbolToken(Token::Type type) {
+    return {type,
+            {tokenLine, tokenCol},
+            &strTbl.findOrInsert(tokenString.data(), tokenString.size(),
+                                 tokenHash)};
   }
 
   [[noreturn]] void error(std::string msg) {
@@ -338,49 +388,42 @@ class Lexer {
 
 public:
   void readIntoBuffer() {
-    bufferStartOffset = input.tellg();
-    input.read(&buffer[0], maxBufferSize);
-    streamIsEof = input.eof();
-    curBufferSize = input.gcount();
+    bufferStartOffset = input->tellg();
+    input->read(&streamBuffer[0], maxBufferSize);
+    streamIsEof = input->eof();
+    curBufferSize = input->gcount();
     nextCharPos = 0;
-    if (streamIsEof) {
-      buffer[curBufferSize] = EOF;
-    }
   }
 
-  bool isEof() const {
-    return streamIsEof && (nextCharPos - 1 == curBufferSize);
-  }
+  bool isEof() const { return streamIsEof && (nextCharPos > curBufferSize); }
 
-  Lexer(const InputFile &inputFile)
-      : input(*inputFile.getStream()), filename(inputFile.getFilename()) {
-    if (!input) {
-      error(std::string("Broken input stream: ") + std::strerror(errno));
+  Lexer(const InputFile &inputFile, SymbolTable::StringTable &strTbl)
+      : filename(inputFile.getFilename()), strTbl(strTbl) {
+    if (inputFile.mapFile()) {
+      // the whole file is one buffer which never needs to be refilled
+      buffer = inputFile.getMappedData();
+      curBufferSize = inputFile.getMappedSize();
+      streamIsEof = true;
+    } else {
+      input = inputFile.getStream();
+      if (!*input) {
+        error(std::string("Broken input stream: ") + std::strerror(errno));
+      }
+      readIntoBuffer();
     }
-    lineStartFileOffsets.push_back(0);
-    readIntoBuffer();
     nextChar();
   }
+  Lexer(const Lexer &) = delete;
 
   std::string getCurrentLineFromInput(int lineNr);
 
-  Token nextToken() {
-    if (tokenLookahead.empty()) {
-      return readNextToken();
-    }
-    Token res = std::move(tokenLookahead.front());
-    tokenLookahead.pop_front();
-    return res;
-  }
+  Token nextToken() { return readNextToken(); }
 
-  Token &lookAhead(size_t numTokens) {
-    assert(numTokens > 0);
-    if (numTokens <= tokenLookahead.size()) {
-      return tokenLookahead[numTokens - 1];
-    } else {
-      return peekAhead(numTokens);
-    }
-  }
+  /// reads the whole input in one go. A lexer error is stored in the buffer
+  /// and thrown once the token at which it occurred is requested.
+  /// With MJC_LEX_THREADS=<n>, memory mapped inputs are split into n chunks
+  /// which are lexed in parallel.
+  TokenBuffer readAllTokens();
 
   const std::string &getFilename() const { return filename; }
 
@@ -388,15 +431,26 @@ public:
   static const char *getTokenName(Token::Type type);
 
 private:
-  Token &peekAhead(size_t numTokens) {
-    for (size_t i = tokenLookahead.size(); i <= numTokens; ++i) {
-      tokenLookahead.push_back(readNextToken());
-    }
-    return tokenLookahead[numTokens - 1];
+  // lexes the memory range [data, data + size), used for the chunks of
+  // parallel lexing
+  Lexer(const char *data, size_t size, std::string filename,
+        SymbolTable::StringTable &strTbl)
+      : filename(std::move(filename)), strTbl(strTbl) {
+    buffer = data;
+    curBufferSize = size;
+    streamIsEof = true;
+    nextChar();
   }
+
+  TokenBuffer readAllTokensSequential();
+  TokenBuffer readAllTokensParallel(unsigned numThreads);
+
   Token readNextToken();
 
   // Parser helper functions
+  static bool useDfaBackend();
+  inline Token readTokenDFA();
+
   inline bool skipCommentsAndWhitespaces();
   inline Token readSlashFromSecondCharOn();
   inline Token readDecNumber();
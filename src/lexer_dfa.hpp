@@ -0,0 +1,119 @@
+#ifndef LEXER_DFA_H
+#define LEXER_DFA_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "lexer.hpp"
+
+// Transition and accept tables of the table driven tokenizer
+// (Lexer::readTokenDFA), generated at compile time from the token spellings
+// below, which follow test/minijava.l.
+//
+// The DFA only recognizes single tokens after whitespaces and comments were
+// skipped. Keywords are recognized as identifiers and looked up afterwards,
+// '/' and "/=" are handled together with comments.
+namespace LexerDFA {
+
+struct Rule {
+  const char *spelling;
+  size_t length;
+  Token::Type type;
+};
+
+#define OPERATOR(spelling, type)                                               \
+  { spelling, sizeof(spelling) - 1, Token::Type::type }
+constexpr Rule operators[] = {
+    OPERATOR("!=", BangEq),     OPERATOR("!", Bang),
+    OPERATOR("(", LParen),      OPERATOR(")", RParen),
+    OPERATOR("*=", StarEq),     OPERATOR("*", Star),
+    OPERATOR("++", PlusPlus),   OPERATOR("+=", PlusEq),
+    OPERATOR("+", Plus),        OPERATOR(",", Comma),
+    OPERATOR("-=", MinusEq),    OPERATOR("--", MinusMinus),
+    OPERATOR("-", Minus),       OPERATOR(".", Dot),
+    OPERATOR(":", Colon),       OPERATOR(";", Semicolon),
+    OPERATOR("<<=", LtLtEq),    OPERATOR("<<", LtLt),
+    OPERATOR("<=", LtEq),       OPERATOR("<", Lt),
+    OPERATOR("==", EqEq),       OPERATOR("=", Eq),
+    OPERATOR(">=", GtEq),       OPERATOR(">>=", GtGtEq),
+    OPERATOR(">>>=", GtGtGtEq), OPERATOR(">>>", GtGtGt),
+    OPERATOR(">>", GtGt),       OPERATOR(">", Gt),
+    OPERATOR("?", QMark),       OPERATOR("%=", PercentEq),
+    OPERATOR("%", Percent),     OPERATOR("&=", AmpEq),
+    OPERATOR("&&", AmpAmp),     OPERATOR("&", Amp),
+    OPERATOR("[", LBracket),    OPERATOR("]", RBracket),
+    OPERATOR("^=", CaretEq),    OPERATOR("^", Caret),
+    OPERATOR("{", LBrace),      OPERATOR("}", RBrace),
+    OPERATOR("~", Tilde),       OPERATOR("|=", VBarEq),
+    OPERATOR("||", VBarVBar),   OPERATOR("|", VBar),
+};
+#undef OPERATOR
+
+using State = uint8_t;
+constexpr State dead = 0, start = 1, ident = 2, zero = 3, number = 4,
+                firstOperatorState = 5;
+constexpr size_t maxStates = 64;
+
+struct Tables {
+  // indexed by the char as unsigned char
+  State next[maxStates][256];
+  Token::Type accept[maxStates];
+  size_t numStates;
+};
+
+constexpr bool isAlphaOrUnderscore(int c) {
+  return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
+}
+constexpr bool isDigit(int c) { return '0' <= c && c <= '9'; }
+
+constexpr Tables buildTables() {
+  Tables t{};
+  // identifiers [_a-zA-Z][_a-zA-Z0-9]* and numbers 0|[1-9][0-9]*
+  for (int c = 0; c < 256; ++c) {
+    if (isAlphaOrUnderscore(c)) {
+      t.next[start][c] = ident;
+      t.next[ident][c] = ident;
+    } else if (isDigit(c)) {
+      t.next[start][c] = c == '0' ? zero : number;
+      t.next[ident][c] = ident;
+      t.next[number][c] = number;
+    }
+  }
+  t.accept[ident] = Token::Type::Identifier;
+  t.accept[zero] = Token::Type::IntLiteral;
+  t.accept[number] = Token::Type::IntLiteral;
+
+  // operators form a trie below the start state
+  t.numStates = firstOperatorState;
+  for (const Rule &op : operators) {
+    State s = start;
+    for (size_t i = 0; i < op.length; ++i) {
+      auto c = static_cast<unsigned char>(op.spelling[i]);
+      if (t.next[s][c] == dead) {
+        t.next[s][c] = static_cast<State>(t.numStates++);
+      }
+      s = t.next[s][c];
+    }
+    t.accept[s] = op.type;
+  }
+  return t;
+}
+
+constexpr Tables tables = buildTables();
+
+// every prefix of a token is a token itself, so the lexer can stop at the
+// first dead transition and never has to backtrack
+constexpr bool allStatesAccept() {
+  for (size_t s = start + 1; s < tables.numStates; ++s) {
+    if (tables.accept[s] == Token::Type::none) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(tables.numStates <= maxStates, "too many DFA states");
+static_assert(allStatesAccept(), "DFA needs backtracking");
+}
+
+#endif // LEXER_DFA_H
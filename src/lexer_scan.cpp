@@ -0,0 +1,294 @@
+#include "lexer_scan.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LEXER_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace LexerScan {
+
+static bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool isLineBreak(const char *p, size_t i) {
+  return p[i] == '\n' || (p[i] == '\r' && p[i + 1] != '\n');
+}
+
+// the scalar versions are also used for the remainder of the vector kernels
+
+static size_t findNonSpaceScalar(const char *p, size_t i, size_t n) {
+  while (i < n && isSpace(p[i]))
+    ++i;
+  return i;
+}
+
+static size_t findCommentEndScalar(const char *p, size_t i, size_t n) {
+  for (; i < n; ++i) {
+    if (p[i] & 0b1000'0000)
+      return i;
+    if (p[i] == '*' && i + 1 < n && p[i + 1] == '/')
+      return i;
+  }
+  return n;
+}
+
+static void scanLinesScalar(const char *p, size_t i, size_t n,
+                            LineInfo &info) {
+  for (; i < n; ++i) {
+    if (isLineBreak(p, i)) {
+      ++info.lines;
+      info.lastBreak = i;
+      info.tabs = 0;
+    } else if (p[i] == '\t') {
+      ++info.tabs;
+    }
+  }
+}
+
+static void findLineStartsScalar(const char *p, size_t i, size_t n,
+                                 std::vector<std::streamoff> &lineStarts,
+                                 std::streamoff offset) {
+  for (; i < n; ++i) {
+    if (isLineBreak(p, i)) {
+      lineStarts.push_back(offset + i + 1);
+    }
+  }
+}
+
+// mask: one bit per char of the block starting at p[i]
+static void addLineBreaks(uint32_t breaks, uint32_t tabs, size_t i,
+                          LineInfo &info) {
+  if (!breaks) {
+    info.tabs += __builtin_popcount(tabs);
+    return;
+  }
+  unsigned last = 31 - __builtin_clz(breaks);
+  info.lines += __builtin_popcount(breaks);
+  info.lastBreak = i + last;
+  info.tabs = __builtin_popcount((tabs >> last) >> 1);
+}
+
+static void addLineStarts(uint32_t breaks, size_t i,
+                          std::vector<std::streamoff> &lineStarts,
+                          std::streamoff offset) {
+  while (breaks) {
+    lineStarts.push_back(offset + i + __builtin_ctz(breaks) + 1);
+    breaks &= breaks - 1;
+  }
+}
+
+static size_t findNonSpaceScalar(const char *p, size_t n) {
+  return findNonSpaceScalar(p, 0, n);
+}
+static size_t findCommentEndScalar(const char *p, size_t n) {
+  return findCommentEndScalar(p, 0, n);
+}
+static void scanLinesScalar(const char *p, size_t n, LineInfo &info) {
+  scanLinesScalar(p, 0, n, info);
+}
+static void findLineStartsScalar(const char *p, size_t n,
+                                 std::vector<std::streamoff> &lineStarts,
+                                 std::streamoff offset) {
+  findLineStartsScalar(p, 0, n, lineStarts, offset);
+}
+
+#ifdef LEXER_SCAN_X86
+
+// -- SSE2 (always available on x86-64)
+
+static uint32_t spaceMaskSSE2(__m128i v) {
+  __m128i ws = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+  return _mm_movemask_epi8(ws);
+}
+
+static size_t findNonSpaceSSE2(const char *p, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    uint32_t nonSpace = ~spaceMaskSSE2(v) & 0xffff;
+    if (nonSpace)
+      return i + __builtin_ctz(nonSpace);
+  }
+  return findNonSpaceScalar(p, i, n);
+}
+
+static size_t findCommentEndSSE2(const char *p, size_t n) {
+  size_t i = 0;
+  for (; i + 17 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    __m128i next =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 1));
+    __m128i end = _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('*')),
+                                _mm_cmpeq_epi8(next, _mm_set1_epi8('/')));
+    // movemask of v itself yields the high bits
+    uint32_t mask = _mm_movemask_epi8(end) | _mm_movemask_epi8(v);
+    if (mask)
+      return i + __builtin_ctz(mask);
+  }
+  return findCommentEndScalar(p, i, n);
+}
+
+// one bit per line break (LF, or CR not followed by LF) in p[0, 16);
+// p[16] has to be readable
+static uint32_t breakMaskSSE2(const char *p) {
+  __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+  __m128i lf = _mm_set1_epi8('\n');
+  __m128i breaks = _mm_or_si128(
+      _mm_cmpeq_epi8(v, lf),
+      _mm_andnot_si128(_mm_cmpeq_epi8(next, lf),
+                       _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+  return _mm_movemask_epi8(breaks);
+}
+
+static void scanLinesSSE2(const char *p, size_t n, LineInfo &info) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    __m128i tabs = _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'));
+    addLineBreaks(breakMaskSSE2(p + i), _mm_movemask_epi8(tabs), i, info);
+  }
+  scanLinesScalar(p, i, n, info);
+}
+
+static void findLineStartsSSE2(const char *p, size_t n,
+                               std::vector<std::streamoff> &lineStarts,
+                               std::streamoff offset) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    addLineStarts(breakMaskSSE2(p + i), i, lineStarts, offset);
+  }
+  findLineStartsScalar(p, i, n, lineStarts, offset);
+}
+
+// -- AVX2
+
+#define AVX2_TARGET __attribute__((target("avx2,popcnt")))
+
+AVX2_TARGET static uint32_t spaceMaskAVX2(__m256i v) {
+  __m256i ws = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+  return _mm256_movemask_epi8(ws);
+}
+
+AVX2_TARGET static size_t findNonSpaceAVX2(const char *p, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    uint32_t nonSpace = ~spaceMaskAVX2(v);
+    if (nonSpace)
+      return i + __builtin_ctz(nonSpace);
+  }
+  return i + findNonSpaceSSE2(p + i, n - i);
+}
+
+AVX2_TARGET static size_t findCommentEndAVX2(const char *p, size_t n) {
+  size_t i = 0;
+  for (; i + 33 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    __m256i next =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + 1));
+    __m256i end =
+        _mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('*')),
+                         _mm256_cmpeq_epi8(next, _mm256_set1_epi8('/')));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(end)) |
+                    static_cast<uint32_t>(_mm256_movemask_epi8(v));
+    if (mask)
+      return i + __builtin_ctz(mask);
+  }
+  return i + findCommentEndSSE2(p + i, n - i);
+}
+
+AVX2_TARGET static uint32_t breakMaskAVX2(const char *p) {
+  __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1));
+  __m256i lf = _mm256_set1_epi8('\n');
+  __m256i breaks = _mm256_or_si256(
+      _mm256_cmpeq_epi8(v, lf),
+      _mm256_andnot_si256(_mm256_cmpeq_epi8(next, lf),
+                          _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+  return _mm256_movemask_epi8(breaks);
+}
+
+AVX2_TARGET static void scanLinesAVX2(const char *p, size_t n,
+                                      LineInfo &info) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    __m256i tabs = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'));
+    addLineBreaks(breakMaskAVX2(p + i), _mm256_movemask_epi8(tabs), i, info);
+  }
+  if (i < n) { // use SSE2 for the remainder, indentation is mostly short
+    LineInfo rest;
+    scanLinesSSE2(p + i, n - i, rest);
+    if (rest.lines > 0) {
+      info.lines += rest.lines;
+      info.lastBreak = i + rest.lastBreak;
+      info.tabs = rest.tabs;
+    } else {
+      info.tabs += rest.tabs;
+    }
+  }
+}
+
+AVX2_TARGET static void
+findLineStartsAVX2(const char *p, size_t n,
+                   std::vector<std::streamoff> &lineStarts,
+                   std::streamoff offset) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    addLineStarts(breakMaskAVX2(p + i), i, lineStarts, offset);
+  }
+  findLineStartsSSE2(p + i, n - i, lineStarts, offset + i);
+}
+
+#undef AVX2_TARGET
+
+#endif // LEXER_SCAN_X86
+
+static const Kernels scalarKernels{"scalar", findNonSpaceScalar,
+                                   findCommentEndScalar, scanLinesScalar,
+                                   findLineStartsScalar};
+#ifdef LEXER_SCAN_X86
+static const Kernels sse2Kernels{"sse2", findNonSpaceSSE2, findCommentEndSSE2,
+                                 scanLinesSSE2, findLineStartsSSE2};
+static const Kernels avx2Kernels{"avx2", findNonSpaceAVX2, findCommentEndAVX2,
+                                 scanLinesAVX2, findLineStartsAVX2};
+#endif
+
+static const Kernels &selectKernels() {
+  const char *requested = std::getenv("MJC_LEXER_KERNEL");
+  if (requested && std::strcmp(requested, "scalar") == 0) {
+    return scalarKernels;
+  }
+#ifdef LEXER_SCAN_X86
+  __builtin_cpu_init();
+  bool hasAVX2 = __builtin_cpu_supports("avx2");
+  bool hasSSE2 = __builtin_cpu_supports("sse2");
+  if (requested && std::strcmp(requested, "avx2") == 0 && hasAVX2) {
+    return avx2Kernels;
+  }
+  if (hasSSE2) {
+    return sse2Kernels;
+  }
+#endif
+  return scalarKernels;
+}
+
+const Kernels &getKernels() {
+  static const Kernels &kernels = selectKernels();
+  return kernels;
+}
+}
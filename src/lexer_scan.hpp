@@ -0,0 +1,49 @@
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+#include <cstddef>
+#include <ios>
+#include <vector>
+
+// Block scanning kernels used by the lexer to skip whitespace and comments
+// without going through Lexer::nextChar() for every character, and to build
+// the line index for error messages.
+namespace LexerScan {
+
+struct LineInfo {
+  // number of line breaks (LF, CR LF or a lone CR)
+  size_t lines = 0;
+  // index of the last line break, only valid if lines > 0
+  size_t lastBreak = 0;
+  // tabs after the last line break (all tabs if there is none)
+  size_t tabs = 0;
+};
+
+struct Kernels {
+  const char *name;
+
+  // index of the first char in p[0, n) which is no whitespace, n if none
+  size_t (*findNonSpace)(const char *p, size_t n);
+
+  // index of the first "*/" or char with the high bit set in p[0, n),
+  // n if none
+  size_t (*findCommentEnd)(const char *p, size_t n);
+
+  // collects line breaks and tabs in p[0, n). p[n] has to be readable to
+  // decide whether a trailing CR is followed by a LF.
+  void (*scanLines)(const char *p, size_t n, LineInfo &info);
+
+  // appends the offset of the char following each line break in p[0, n)
+  // (offset + index + 1) to lineStarts. p[n] has to be readable as above.
+  void (*findLineStarts)(const char *p, size_t n,
+                         std::vector<std::streamoff> &lineStarts,
+                         std::streamoff offset);
+};
+
+// the SSE2 kernels if the cpu supports them, the scalar ones otherwise; can be
+// overridden with the environment variable MJC_LEXER_KERNEL=scalar|sse2|avx2.
+// AVX2 is slower than SSE2 on typical input, so it is only used on request.
+const Kernels &getKernels();
+}
+
+#endif // LEXER_SCAN_H
@@ -0,0 +1,349 @@
+#ifndef LICM_PASS
+#define LICM_PASS
+
+#include "firm_pass.hpp"
+
+#include <iostream>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Loop invariant code motion. Moves arithmetic whose operands are defined
+// outside of a loop into the block in front of the loop header, and the same
+// for loads from an invariant address which no store or method call in the
+// loop may overwrite. Nodes are moved as far out as possible. Comparisons
+// stay next to their Cond, the backend generates both together.
+//
+// Runs after lowering, so fields and array elements are plain address
+// arithmetic and aliasing is decided on the modes and constant offsets of
+// the addresses, see mayAlias.
+class LoopInvariantPass : public FunctionPass<LoopInvariantPass> {
+  struct LoopData {
+    // preheader is the only block outside of the loop jumping to the header,
+    // nullptr if there is none and nothing can be moved out of the loop
+    ir_node *header = nullptr;
+    ir_node *preheader = nullptr;
+    int entryIndex = -1;
+    bool initialized = false;
+    // loads aren't moved across calls of methods, runtime functions don't
+    // write the memory of the program
+    bool callsMethods = false;
+    std::vector<ir_node *> stores;
+    // the blocks of the loop with a successor outside of it
+    std::vector<ir_node *> exits;
+  };
+  std::unordered_map<ir_loop *, LoopData> loops;
+  std::vector<ir_node *> nodes;
+  unsigned hoisted = 0;
+
+public:
+  LoopInvariantPass(ir_graph *firmgraph) : FunctionPass(firmgraph) {
+    assure_doms(graph);
+    assure_loopinfo(graph);
+  }
+
+  void before() { edges_activate(graph); }
+
+  // collected first, the stores of a loop have to be known before a load is
+  // moved. The worklist has operands before their users except for Phis.
+  void defaultVisitOp(ir_node *node) { nodes.push_back(node); }
+
+  void after() {
+    for (auto node : nodes) {
+      if (is_Store(node) || is_Call(node)) {
+        recordSideEffect(node);
+      } else if (is_Block(node)) {
+        recordExits(node);
+      }
+    }
+    for (auto node : nodes) {
+      if (isHoistable(node) && hoist(node)) {
+        ++hoisted;
+      }
+    }
+    changed = hoisted > 0;
+    edges_deactivate(graph);
+  }
+
+  unsigned getNumChanges() const { return hoisted; }
+
+  static void printStats(std::ostream &out, unsigned numHoisted) {
+    out << "licm: hoisted " << numHoisted << " nodes out of loops"
+        << std::endl;
+  }
+
+private:
+  static bool isHoistable(ir_node *node) {
+    switch (get_irn_opcode(node)) {
+    case iro_Add:
+    case iro_Sub:
+    case iro_Mul:
+    case iro_Minus:
+    case iro_Conv:
+    case iro_And:
+    case iro_Or:
+    case iro_Eor:
+    case iro_Not:
+    case iro_Shl:
+    case iro_Shr:
+    case iro_Shrs:
+    case iro_Load:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // the innermost loop of block, nullptr outside of loops
+  ir_loop *getLoop(ir_node *block) {
+    ir_loop *loop = get_irn_loop(block);
+    if (loop == nullptr || get_loop_depth(loop) == 0) {
+      return nullptr;
+    }
+    return loop;
+  }
+
+  bool isInLoop(ir_node *block, ir_loop *loop) {
+    for (ir_loop *l = getLoop(block); l != nullptr;
+         l = get_loop_depth(l) > 1 ? get_loop_outer_loop(l) : nullptr) {
+      if (l == loop) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void recordSideEffect(ir_node *node) {
+    // methods belong to their class, runtime functions are global. Graphs
+    // can't be used to tell, in --stream mode most don't exist yet.
+    bool callsMethod =
+        is_Call(node) &&
+        get_entity_owner(get_Call_callee(node)) != get_glob_type();
+    if (is_Call(node) && !callsMethod) {
+      return;
+    }
+    for (ir_loop *l = getLoop(get_nodes_block(node)); l != nullptr;
+         l = get_loop_depth(l) > 1 ? get_loop_outer_loop(l) : nullptr) {
+      if (callsMethod) {
+        loops[l].callsMethods = true;
+      } else {
+        loops[l].stores.push_back(node);
+      }
+    }
+  }
+
+  void recordExits(ir_node *block) {
+    for (int i = 0; i < get_Block_n_cfgpreds(block); ++i) {
+      ir_node *pred = get_Block_cfgpred(block, i);
+      if (is_Bad(pred)) {
+        continue;
+      }
+      ir_node *predBlock = get_nodes_block(pred);
+      for (ir_loop *l = getLoop(predBlock); l != nullptr;
+           l = get_loop_depth(l) > 1 ? get_loop_outer_loop(l) : nullptr) {
+        if (!isInLoop(block, l)) {
+          loops[l].exits.push_back(predBlock);
+        }
+      }
+    }
+  }
+
+  // block is any block of the loop
+  LoopData &getLoopData(ir_loop *loop, ir_node *block) {
+    auto &data = loops[loop];
+    if (data.initialized) {
+      return data;
+    }
+    data.initialized = true;
+
+    // the header dominates all blocks of the loop
+    ir_node *header = block;
+    for (ir_node *idom = get_Block_idom(header);
+         idom != nullptr && isInLoop(idom, loop); idom = get_Block_idom(idom)) {
+      header = idom;
+    }
+    data.header = header;
+
+    for (int i = 0; i < get_Block_n_cfgpreds(header); ++i) {
+      ir_node *pred = get_Block_cfgpred(header, i);
+      if (is_Bad(pred) || isInLoop(get_nodes_block(pred), loop)) {
+        continue;
+      }
+      if (data.entryIndex != -1 || !is_Jmp(pred)) {
+        // more than one entry or the entry is a branch, no place to move to
+        data.preheader = nullptr;
+        return data;
+      }
+      data.entryIndex = i;
+      data.preheader = get_nodes_block(pred);
+    }
+    return data;
+  }
+
+  // moves node out of as many loops as possible, returns whether it was
+  // moved at all
+  bool hoist(ir_node *node) {
+    bool moved = false;
+    while (ir_loop *loop = getLoop(get_nodes_block(node))) {
+      auto &data = getLoopData(loop, get_nodes_block(node));
+      if (data.preheader == nullptr) {
+        break;
+      }
+      for (int i = 0; i < get_irn_arity(node); ++i) {
+        if (is_Load(node) && i == n_Load_mem) {
+          continue; // checked in canHoistLoad
+        }
+        if (isInLoop(get_nodes_block(get_irn_n(node, i)), loop)) {
+          return moved;
+        }
+      }
+      if (is_Load(node)) {
+        ir_node *mem = nullptr;
+        if (!canHoistLoad(node, loop, data, mem)) {
+          break;
+        }
+        // take the load out of the memory chain of the loop
+        foreach_out_edge_safe(node, edge) {
+          ir_node *proj = get_edge_src_irn(edge);
+          if (get_irn_mode(proj) == mode_M) {
+            exchange(proj, get_Load_mem(node));
+          } else {
+            set_nodes_block(proj, data.preheader);
+          }
+        }
+        set_Load_mem(node, mem);
+      }
+      set_nodes_block(node, data.preheader);
+      moved = true;
+    }
+    return moved;
+  }
+
+  // A load may fault, so it may only be moved if it's executed whenever the
+  // loop is entered: it's in the header or in a block dominating all exits
+  // of the loop. On success mem is the memory state in front of the loop.
+  bool canHoistLoad(ir_node *load, ir_loop *loop, LoopData &data,
+                    ir_node *&mem) {
+    ir_node *block = get_nodes_block(load);
+    if (block != data.header && !dominatesExits(block, data)) {
+      return false;
+    }
+    ir_node *ptr = get_Load_ptr(load);
+    if (data.callsMethods) {
+      return false;
+    }
+    for (auto store : data.stores) {
+      if (mayAlias(get_Store_ptr(store), get_irn_mode(get_Store_value(store)),
+                   ptr, get_Load_mode(load))) {
+        return false;
+      }
+    }
+    std::unordered_set<ir_node *> visited;
+    return findMemoryBeforeLoop(get_Load_mem(load), loop, data, visited, mem);
+  }
+
+  // a loop without exits never ends, the block may never be reached
+  static bool dominatesExits(ir_node *block, const LoopData &data) {
+    if (data.exits.empty()) {
+      return false;
+    }
+    for (auto exit : data.exits) {
+      if (!block_dominates(block, exit)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Splits an address into an object and a constant offset. Objects and
+  // arrays are separate allocations, so two addresses with a known offset
+  // only overlap if the offsets are equal. Returns false for array elements
+  // with a computed index.
+  static bool getConstOffset(ir_node *ptr, long &offset) {
+    offset = 0;
+    if (!is_Add(ptr)) {
+      return true;
+    }
+    ir_node *left = get_Add_left(ptr);
+    ir_node *right = get_Add_right(ptr);
+    if (is_Const(left)) {
+      std::swap(left, right);
+    }
+    if (!is_Const(right) || is_Add(left)) {
+      return false;
+    }
+    offset = get_tarval_long(get_Const_tarval(right));
+    return true;
+  }
+
+  // memory is typed, a location is always accessed with the same mode
+  static bool mayAlias(ir_node *storePtr, ir_mode *storeMode,
+                       ir_node *loadPtr, ir_mode *loadMode) {
+    if (storeMode != loadMode) {
+      return false;
+    }
+    long storeOffset, loadOffset;
+    if (!getConstOffset(storePtr, storeOffset) ||
+        !getConstOffset(loadPtr, loadOffset)) {
+      return true;
+    }
+    return storeOffset == loadOffset;
+  }
+
+  // Follows the memory chain of a load up to the state in front of the loop.
+  // Nothing in the loop writes the loaded location, so all paths have to end
+  // in the same state, which is stored in mem.
+  bool findMemoryBeforeLoop(ir_node *node, ir_loop *loop, LoopData &data,
+                            std::unordered_set<ir_node *> &visited,
+                            ir_node *&mem) {
+    while (isInLoop(get_nodes_block(node), loop)) {
+      if (is_Phi(node)) {
+        if (get_nodes_block(node) == data.header) {
+          node = get_irn_n(node, data.entryIndex);
+          break;
+        }
+        if (!visited.insert(node).second) {
+          return true; // a cycle of an inner loop, already followed
+        }
+        for (int i = 0; i < get_irn_arity(node); ++i) {
+          if (!findMemoryBeforeLoop(get_irn_n(node, i), loop, data, visited,
+                                    mem)) {
+            return false;
+          }
+        }
+        return true;
+      }
+      if (!is_Proj(node)) {
+        return false;
+      }
+      ir_node *pred = get_Proj_pred(node);
+      switch (get_irn_opcode(pred)) {
+      case iro_Load:
+        node = get_Load_mem(pred);
+        break;
+      case iro_Store:
+        node = get_Store_mem(pred);
+        break;
+      case iro_Call:
+        node = get_Call_mem(pred);
+        break;
+      case iro_Div:
+        node = get_Div_mem(pred);
+        break;
+      case iro_Mod:
+        node = get_Mod_mem(pred);
+        break;
+      default:
+        return false;
+      }
+    }
+    if (mem != nullptr && mem != node) {
+      return false;
+    }
+    mem = node;
+    return true;
+  }
+};
+
+#endif // LICM_PASS
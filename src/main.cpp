@@ -1,6 +1,8 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <cstdlib>
 
@@ -12,6 +14,18 @@
 auto cl_cout = co::make_colored(std::cout);
 auto cl_cerr = co::make_colored(std::cerr);
 
+// maps gcc style -fpass=<name> and -fno-pass=<name> to the long options
+static std::pair<std::string, std::string>
+parsePassOption(const std::string &arg) {
+  for (std::string option : {"fpass", "fno-pass"}) {
+    std::string prefix = '-' + option + '=';
+    if (arg.compare(0, prefix.size(), prefix) == 0) {
+      return {option, arg.substr(prefix.size())};
+    }
+  }
+  return {};
+}
+
 CompilerOptions parseArguments(int argc, char *argv[]) {
   CompilerOptions compilerOptions;
 
@@ -54,8 +68,17 @@ CompilerOptions parseArguments(int argc, char *argv[]) {
       ("output-assembly,S", "write generated assembly to <output>.s")
       // disable verification
       ("no-verify", "disable verification when building firm graph")
+      // compile method by method
+      ("stream", "compile one method at a time to bound memory use")
       // optimize
-      ("optimize,O", bpo::value<int>()->default_value(2), "optimization level (default: 2)")
+      ("optimize,O", bpo::value<int>()->default_value(2), "optimization level 0-3 (default: 2)")
+      // select single optimization passes
+      ("fpass", bpo::value<std::vector<std::string>>(&compilerOptions.enabledPasses)->composing(),
+       "-fpass=<name>: run optimization pass <name> regardless of the level")
+      ("fno-pass", bpo::value<std::vector<std::string>>(&compilerOptions.disabledPasses)->composing(),
+       "-fno-pass=<name>: don't run optimization pass <name>")
+      // optimization statistics
+      ("opt-stats", "print what the optimization passes did")
       // output file
       ("output,o", bpo::value<std::string>(&compilerOptions.outputFileName),
        "output file name");
@@ -65,6 +88,7 @@ CompilerOptions parseArguments(int argc, char *argv[]) {
     bpo::store(bpo::command_line_parser(argc, argv)
                    .options(desc)
                    .positional(posArgs)
+                   .extra_parser(parsePassOption)
                    .run(),
                var_map);
 
@@ -125,8 +149,15 @@ CompilerOptions parseArguments(int argc, char *argv[]) {
     if (var_map.count("no-verify")) {
       compilerOptions.noVerify = true;
     }
+    if (var_map.count("stream")) {
+      compilerOptions.streaming = true;
+    }
+    if (var_map.count("opt-stats")) {
+      compilerOptions.printOptStats = true;
+    }
     if (var_map.count("optimize")) {
-      if (var_map["optimize"].as<int>() == 0) {
+      compilerOptions.optimizationLevel = var_map["optimize"].as<int>();
+      if (compilerOptions.optimizationLevel == 0) {
         compilerOptions.optimize = false;
       }
     }
@@ -28,52 +28,261 @@
 #define OPTIMIZER_H
 
 #include "const_prop_pass.hpp"
+#include "gvn_pass.hpp"
+#include "inline_pass.hpp"
+#include "licm_pass.hpp"
 #include "unused_fn_remove_pass.hpp"
 #include "firm_pass.hpp"
 #include <libfirm/firm.h>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
+// A program pass which is kept for the whole optimization, so it can carry
+// state from one round to the next.
+class ProgramPassRunner {
+public:
+  virtual ~ProgramPassRunner() {}
+  // returns whether the program was changed
+  virtual bool run() = 0;
+  virtual unsigned getNumChanges() const = 0;
+};
+
+template <typename Pass>
+class ProgramPassRunnerImpl : public ProgramPassRunner {
+  Pass pass;
+
+public:
+  template <typename... Args>
+  ProgramPassRunnerImpl(std::vector<ir_graph *> &graphs, Args... args)
+      : pass(graphs, args...) {}
+
+  bool run() override { return pass.run(); }
+  unsigned getNumChanges() const override { return pass.getNumChanges(); }
+};
+
+// what a program pass may need to know about the rest of the pipeline
+struct PipelineInfo {
+  // unused-fn runs after the other program passes
+  bool removesUnused;
+};
+
+// A pass of the optimization pipeline. Function passes run on one graph at a
+// time, program passes on all graphs at once. Both return whether they changed
+// anything, so the passes can be repeated until they reach a fixpoint.
+struct OptimizationPass {
+  const char *name;
+  const char *description;
+  // the lowest -O level which runs the pass without -fpass=<name>
+  int level;
+  // adds the number of transformations to numChanges
+  bool (*runOnGraph)(ir_graph *, unsigned &numChanges);
+  std::unique_ptr<ProgramPassRunner> (*makeProgramPass)(
+      std::vector<ir_graph *> &, const PipelineInfo &);
+  // prints the number of transformations of all runs for --opt-stats
+  void (*printStats)(std::ostream &, unsigned numChanges);
+
+  bool isFunctionPass() const { return runOnGraph != nullptr; }
+};
+
+template <typename Pass>
+bool runFunctionPass(ir_graph *g, unsigned &numChanges) {
+  Pass pass(g);
+  bool changed = pass.run();
+  numChanges += pass.getNumChanges();
+  return changed;
+}
+
+template <typename Pass>
+std::unique_ptr<ProgramPassRunner>
+makeProgramPass(std::vector<ir_graph *> &graphs, const PipelineInfo &) {
+  return std::unique_ptr<ProgramPassRunner>(
+      new ProgramPassRunnerImpl<Pass>(graphs));
+}
+
+inline std::unique_ptr<ProgramPassRunner>
+makeInlinePass(std::vector<ir_graph *> &graphs, const PipelineInfo &info) {
+  return std::unique_ptr<ProgramPassRunner>(
+      new ProgramPassRunnerImpl<InlinePass>(graphs, info.removesUnused));
+}
+
 class Optimizer
 {
-  std::vector<ir_graph *> &firmGraphs;
-  bool printGraphs, verifyGraphs;
+  std::vector<const OptimizationPass *> pipeline;
+  // transformations per pass of the pipeline, for --opt-stats
+  std::vector<unsigned> numChanges;
+  int maxIterations, maxRounds;
+  bool printGraphs, verifyGraphs, printStats;
 
 public:
-  Optimizer(std::vector<ir_graph *> &firmGraphs, bool printGraphs, bool verifyGraphs)
-      : firmGraphs(firmGraphs), printGraphs(printGraphs), verifyGraphs(verifyGraphs) {}
+  static const int maxLevel = 3;
 
-  int run()
+  // all known passes, in the order they run in
+  static const std::vector<OptimizationPass> &getPasses()
   {
-    int graphErrors = 0;
-    for (auto g : firmGraphs)
+    static const std::vector<OptimizationPass> passes = {
+        {"inline", "inline small methods and ones with a single call site", 3,
+         nullptr, makeInlinePass, InlinePass::printStats},
+        {"constprop", "propagate and fold constants, remove dead branches", 1,
+         runFunctionPass<ConstPropPass>, nullptr, ConstPropPass::printStats},
+        {"gvn", "replace computations of values which are already known", 3,
+         runFunctionPass<GvnPass>, nullptr, GvnPass::printStats},
+        {"licm", "move loop invariant computations and loads out of loops",
+         3, runFunctionPass<LoopInvariantPass>, nullptr,
+         LoopInvariantPass::printStats},
+        {"unused-fn", "remove methods which are never called", 2, nullptr,
+         makeProgramPass<UnusedFnRmPass>, UnusedFnRmPass::printStats},
+    };
+    return passes;
+  }
+
+  static const OptimizationPass *findPass(const std::string &name)
+  {
+    for (auto &pass : getPasses())
     {
-      // -- run optimizer passes --
-      //       ExampleFunctionPass efp(g);
-      //       efp.run();
-      ConstPropPass cpp(g);
-      cpp.run();
+      if (name == pass.name)
+        return &pass;
+    }
+    return nullptr;
+  }
 
+  // Runs the passes of the given -O level, plus the ones named in enable,
+  // minus the ones named in disable. The names have to be known, see
+  // findPass. Higher levels allow more iterations of the function passes
+  // and more rounds of the whole pipeline, -O1 runs each pass only once.
+  Optimizer(int level, const std::vector<std::string> &enable,
+            const std::vector<std::string> &disable, bool printGraphs,
+            bool verifyGraphs, bool printStats)
+      : maxIterations(level <= 1 ? 1 : level == 2 ? 4 : 16),
+        maxRounds(level <= 1 ? 1 : level == 2 ? 2 : 4),
+        printGraphs(printGraphs), verifyGraphs(verifyGraphs),
+        printStats(printStats)
+  {
+    auto contains = [](const std::vector<std::string> &names,
+                       const char *name) {
+      return std::find(names.begin(), names.end(), name) != names.end();
+    };
+    for (auto &pass : getPasses())
+    {
+      bool enabled = pass.level <= level || contains(enable, pass.name);
+      if (enabled && !contains(disable, pass.name))
+        pipeline.push_back(&pass);
+    }
+    numChanges.resize(pipeline.size());
+  }
 
+  bool hasPasses() const { return !pipeline.empty(); }
 
-      // -- print graphs and verify if necessary --
+  // Runs the whole pipeline on the program, returns false if a graph doesn't
+  // verify afterwards. The function passes between two program passes are
+  // repeated on each graph until they reach a fixpoint, then the program pass
+  // runs once. The pipeline is repeated in further rounds while it changes
+  // anything, so the passes can work on the results of inlining and the other
+  // way round. Program passes keep their state over all rounds.
+  bool run(std::vector<ir_graph *> &firmGraphs)
+  {
+    PipelineInfo info;
+    info.removesUnused = std::find(pipeline.begin(), pipeline.end(),
+                                   findPass("unused-fn")) != pipeline.end();
+    std::vector<std::unique_ptr<ProgramPassRunner>> programPasses;
+    for (auto *pass : pipeline)
+    {
+      programPasses.push_back(pass->isFunctionPass()
+                                  ? nullptr
+                                  : pass->makeProgramPass(firmGraphs, info));
+    }
 
-      if (printGraphs)
+    for (int round = 0; round < maxRounds; ++round)
+    {
+      bool changed = false;
+      size_t begin = 0;
+      while (begin < pipeline.size())
       {
-        dump_ir_graph(g, "opt");
+        if (programPasses[begin])
+        {
+          changed |= programPasses[begin]->run();
+          ++begin;
+          continue;
+        }
+        size_t end = begin;
+        while (end < pipeline.size() && !programPasses[end])
+          ++end;
+        for (auto g : firmGraphs)
+          changed |= runFunctionPasses(g, begin, end);
+        begin = end;
       }
+      if (!changed)
+        break;
+    }
+
+    for (size_t i = 0; i < pipeline.size(); ++i)
+    {
+      if (programPasses[i])
+        numChanges[i] = programPasses[i]->getNumChanges();
+    }
+    if (printStats)
+      printStatistics(std::cout);
 
-      if (verifyGraphs)
+    int graphErrors = 0;
+    for (auto g : firmGraphs)
+    {
+      if (!dumpAndVerify(g))
+        graphErrors++;
+    }
+    return graphErrors == 0;
+  }
+
+  // runs the function passes of the pipeline on a single graph, returns false
+  // if it doesn't verify afterwards
+  bool optimizeGraph(ir_graph *g)
+  {
+    runFunctionPasses(g, 0, pipeline.size());
+    return dumpAndVerify(g);
+  }
+
+  // prints what each pass of the pipeline did in all runs so far
+  void printStatistics(std::ostream &out) const
+  {
+    for (size_t i = 0; i < pipeline.size(); ++i)
+      pipeline[i]->printStats(out, numChanges[i]);
+  }
+
+private:
+  // repeats the function passes in [begin, end) of the pipeline on the graph
+  // until they don't change it anymore, returns whether they changed it
+  bool runFunctionPasses(ir_graph *g, size_t begin, size_t end)
+  {
+    bool changedAny = false;
+    for (int i = 0; i < maxIterations; ++i)
+    {
+      bool changed = false;
+      for (size_t p = begin; p < end; ++p)
       {
-        if (irg_verify(g) == 0)
-          graphErrors++;
+        if (pipeline[p]->isFunctionPass())
+          changed |= pipeline[p]->runOnGraph(g, numChanges[p]);
       }
+      if (!changed)
+        break;
+      changedAny = true;
     }
-    if (graphErrors)
-      return false;
+    return changedAny;
+  }
 
-    UnusedFnRmPass ufrp(firmGraphs);
-    ufrp.run();
+  // -- print graphs and verify if necessary --
+  bool dumpAndVerify(ir_graph *g)
+  {
+    if (printGraphs)
+    {
+      dump_ir_graph(g, "opt");
+    }
 
+    if (verifyGraphs)
+    {
+      if (irg_verify(g) == 0)
+        return false;
+    }
     return true;
   }
 };
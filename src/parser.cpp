@@ -31,7 +31,7 @@
 #include "lexer.hpp"
 #include "pprinter.hpp"
 
-#include <deque>
+#include <vector>
 
 using TT = Token::Type;
 
@@ -57,8 +57,8 @@ ast::ProgramPtr Parser::parseProgram() {
       break;
     case TT::Eof: {
       auto endPos = curTok.startPos();
-      return ast::make_Ptr<ast::Program>({startPos, endPos},
-                                         std::move(classes));
+      return ast::ProgramPtr{new ast::Program(
+          {startPos, endPos}, std::move(classes), std::move(arena))};
     }
     default:
       errorExpectedAnyOf({TT::Class, TT::Eof});
@@ -68,14 +68,13 @@ ast::ProgramPtr Parser::parseProgram() {
 }
 
 ast::ClassPtr Parser::parseClassDeclaration() {
-  std::string name;
   std::vector<ast::FieldPtr> fields;
   std::vector<ast::RegularMethodPtr> methods;
   std::vector<ast::MainMethodPtr> mainMethods;
 
   auto startPos = curTok.startPos();
   expectAndNext(TT::Class);
-  name = expectGetIdentAndNext(TT::Identifier);
+  auto &name = expectGetIdentAndNext(TT::Identifier).name;
   expectAndNext(TT::LBrace);
   // parse class members:
   while (true) {
@@ -83,9 +82,8 @@ ast::ClassPtr Parser::parseClassDeclaration() {
     case TT::RBrace: {
       auto endPos = curTok.endPos();
       readNextToken();
-      return ast::make_Ptr<ast::Class>({startPos, endPos}, std::move(name),
-                                       std::move(fields), std::move(methods),
-                                       std::move(mainMethods));
+      return create<ast::Class>({startPos, endPos}, name, std::move(fields),
+                                std::move(methods), std::move(mainMethods));
     }
     case TT::Public:
       parseClassMember(fields, methods, mainMethods);
@@ -123,26 +121,25 @@ ast::MainMethodPtr Parser::parseMainMethod() {
   expectAndNext(TT::Static);
   expectAndNext(TT::Void);
   // name must be main (check in semantic analysis):
-  auto methodName = expectGetIdentAndNext(TT::Identifier);
+  auto &methodName = expectGetIdentAndNext(TT::Identifier);
   expectAndNext(TT::LParen);
   expect(TT::Identifier);
-  if (curTok.str != "String") {
-    error("Unexpected '" + curTok.str + "', expected 'String'");
+  if (curTok.sym != &stringSym) {
+    error("Unexpected '" + curTok.str() + "', expected 'String'");
   }
   readNextToken();
   expectAndNext(TT::LBracket);
   expectAndNext(TT::RBracket);
   // name doesn't matter here, but keep for pretty print:
-  auto paramName = expectGetIdentAndNext(TT::Identifier);
+  auto &paramSym = expectGetIdentAndNext(TT::Identifier);
   expectAndNext(TT::RParen);
-  if (curTok.str == "throws") {
+  if (curTok.sym == &throwsSym) {
     readNextToken(); // skip throws
     expectAndNext(TT::Identifier);
   }
   auto block = parseBlock();
-  return ast::make_Ptr<ast::MainMethod>(
-      {startPos, curTok.endPos()}, std::move(methodName),
-      strTbl.findOrInsert(paramName), std::move(block));
+  return create<ast::MainMethod>(
+      {startPos, curTok.endPos()}, methodName, paramSym, std::move(block));
 }
 
 void Parser::parseFieldOrMethod(std::vector<ast::FieldPtr> &fields,
@@ -150,25 +147,24 @@ void Parser::parseFieldOrMethod(std::vector<ast::FieldPtr> &fields,
   auto startPos = curTok.startPos();
   expectAndNext(TT::Public);
   auto type = parseType();
-  auto name = expectGetIdentAndNext(TT::Identifier);
+  auto &nameSym = expectGetIdentAndNext(TT::Identifier);
   switch (curTok.type) {
   case TT::Semicolon: // field
-    fields.emplace_back(ast::make_Ptr<ast::Field>({startPos, curTok.endPos()},
-                                                  std::move(type),
-                                                  strTbl.findOrInsert(name)));
+    fields.emplace_back(create<ast::Field>(
+        {startPos, curTok.endPos()}, std::move(type), nameSym));
     readNextToken();
     return;
   case TT::LParen: { // method
     readNextToken();
     auto params = parseParameterList();
     expectAndNext(TT::RParen);
-    if (curTok.str == "throws") {
+    if (curTok.sym == &throwsSym) {
       readNextToken(); // skip throws
       expectAndNext(TT::Identifier);
     }
     auto block = parseBlock();
-    methods.emplace_back(ast::make_Ptr<ast::RegularMethod>(
-        {startPos, block->getLoc().endToken}, std::move(type), std::move(name),
+    methods.emplace_back(create<ast::RegularMethod>(
+        {startPos, block->getLoc().endToken}, std::move(type), nameSym,
         std::move(params), std::move(block)));
     return;
   }
@@ -209,9 +205,9 @@ ast::ParameterPtr Parser::parseParameter(int idx) {
   auto startPos = curTok.startPos();
   auto type = parseType();
   auto endPos = curTok.endPos();
-  auto ident = expectGetIdentAndNext(TT::Identifier);
-  return ast::make_Ptr<ast::Parameter>({startPos, endPos}, std::move(type),
-                                       strTbl.findOrInsert(ident), idx);
+  auto &ident = expectGetIdentAndNext(TT::Identifier);
+  return create<ast::Parameter>({startPos, endPos}, std::move(type), ident,
+                                idx);
 }
 
 ast::TypePtr Parser::parseType() {
@@ -222,6 +218,7 @@ ast::TypePtr Parser::parseType() {
   while (true) {
     switch (curTok.type) {
     case TT::LBracket:
+      checkArrayDimension(numDimensions);
       readNextToken();
       endPos = curTok.endPos();
       expectAndNext(TT::RBracket);
@@ -229,9 +226,9 @@ ast::TypePtr Parser::parseType() {
       break;
     default:
       if (numDimensions == 0) {
-        return std::move(basicType);
+        return basicType;
       } else {
-        return ast::make_Ptr<ast::ArrayType>(
+        return create<ast::ArrayType>(
             {startPos, endPos}, std::move(basicType), numDimensions);
       }
     }
@@ -247,12 +244,12 @@ ast::BasicTypePtr Parser::parseBasicType() {
     auto type = curTok.type;
     readNextToken();
     auto typeType = ast::PrimitiveType::getTypeForToken(type);
-    return ast::make_Ptr<ast::PrimitiveType>(loc, typeType);
+    return create<ast::PrimitiveType>(loc, typeType);
   }
   case TT::Identifier: {
-    auto ident = std::move(curTok.str);
+    auto &ident = curTok.sym->name;
     readNextToken();
-    return ast::make_Ptr<ast::ClassType>(loc, std::move(ident));
+    return create<ast::ClassType>(loc, ident);
   }
   default:
     errorExpectedAnyOf({TT::Boolean, TT::Identifier, TT::Int, TT::Void});
@@ -276,7 +273,7 @@ ast::BlockPtr Parser::parseBlock() {
         if (statements[i] == nullptr) {
           // do nothing
         } else if (ast::Block *b =
-                       dynamic_cast<ast::Block *>(statements[i].get())) {
+                       dynamic_cast<ast::Block *>(statements[i])) {
           if (!b->getContainsNothingExceptOneSingleLonelyEmptyExpression()) {
             containsNothingExceptOneSingleLonelyEmtpyExpression = false;
           }
@@ -285,7 +282,7 @@ ast::BlockPtr Parser::parseBlock() {
         }
       }
 
-      return ast::make_Ptr<ast::Block>(
+      return create<ast::Block>(
           {startPos, endPos}, std::move(statements),
           containsNothingExceptOneSingleLonelyEmtpyExpression);
     }
@@ -345,8 +342,8 @@ ast::BlockStmtPtr Parser::parseBlockStatement() {
   case TT::While:
     return parseStmt();
   case TT::Identifier: {
-    Token &nextTok = lookAhead(1);
-    Token &afterNextTok = lookAhead(2);
+    Token nextTok = lookAhead(1);
+    Token afterNextTok = lookAhead(2);
     if (nextTok.type == TT::Identifier ||
         (nextTok.type == TT::LBracket && afterNextTok.type == TT::RBracket)) {
       return parseLocalVarDeclStmt();
@@ -363,7 +360,7 @@ ast::BlockStmtPtr Parser::parseBlockStatement() {
 ast::BlockStmtPtr Parser::parseLocalVarDeclStmt() {
   auto startPos = curTok.startPos();
   auto type = parseType();
-  auto ident = expectGetIdentAndNext(TT::Identifier);
+  auto &ident = expectGetIdentAndNext(TT::Identifier);
   switch (curTok.type) {
   case TT::Eq: {
     auto endPos = curTok.endPos();
@@ -373,16 +370,14 @@ ast::BlockStmtPtr Parser::parseLocalVarDeclStmt() {
       endPos = initializer->getLoc().endToken;
     }
     expectAndNext(TT::Semicolon);
-    return ast::make_Ptr<ast::VariableDeclaration>(
-        {startPos, endPos}, std::move(type), strTbl.findOrInsert(ident),
-        std::move(initializer));
+    return create<ast::VariableDeclaration>(
+        {startPos, endPos}, std::move(type), ident, std::move(initializer));
   }
   case TT::Semicolon: {
     auto endPos = curTok.endPos();
     readNextToken();
-    return ast::make_Ptr<ast::VariableDeclaration>(
-        {startPos, endPos}, std::move(type), strTbl.findOrInsert(ident),
-        nullptr);
+    return create<ast::VariableDeclaration>(
+        {startPos, endPos}, std::move(type), ident, nullptr);
   }
   default:
     errorExpectedAnyOf({TT::Eq, TT::Semicolon});
@@ -427,8 +422,7 @@ ast::StmtPtr Parser::parseExprStmt() {
   auto expr = parseExpr();
   auto endPos = curTok.endPos();
   expectAndNext(TT::Semicolon);
-  return ast::make_Ptr<ast::ExpressionStatement>({startPos, endPos},
-                                                 std::move(expr));
+  return create<ast::ExpressionStatement>({startPos, endPos}, std::move(expr));
 }
 
 ast::StmtPtr Parser::parseIfStmt() {
@@ -445,7 +439,7 @@ ast::StmtPtr Parser::parseIfStmt() {
     readNextToken();
     elseStmt = parseStmt();
   }
-  return ast::make_Ptr<ast::IfStatement>(
+  return create<ast::IfStatement>(
       {startPos, endPos}, std::move(condition), std::move(thenStmt),
       elseStmt ? std::move(elseStmt) : nullptr);
 }
@@ -457,14 +451,13 @@ ast::StmtPtr Parser::parseReturnStmt() {
   case TT::Semicolon: {
     auto endPos = curTok.startPos();
     readNextToken();
-    return ast::make_Ptr<ast::ReturnStatement>({startPos, endPos}, nullptr);
+    return create<ast::ReturnStatement>({startPos, endPos}, nullptr);
   }
   default: {
     auto expr = parseExpr();
     auto endPos = curTok.startPos();
     expectAndNext(TT::Semicolon);
-    return ast::make_Ptr<ast::ReturnStatement>({startPos, endPos},
-                                               std::move(expr));
+    return create<ast::ReturnStatement>({startPos, endPos}, std::move(expr));
   }
   }
 }
@@ -478,11 +471,12 @@ ast::StmtPtr Parser::parseWhileStmt() {
   auto stmt = parseStmt();
   auto endPos = curTok.endPos();
 
-  return ast::make_Ptr<ast::WhileStatement>(
+  return create<ast::WhileStatement>(
       {startPos, endPos}, std::move(condition), std::move(stmt));
 }
 
-ast::ExprPtr Parser::parseExpr() { return precedenceParse(0); }
+// expressions nested deeper than this are parsed by parseDeepExpr
+static const int maxRecursiveExprDepth = 64;
 
 static int getOpPrec(Token::Type tt) {
   switch (tt) {
@@ -512,142 +506,398 @@ static int getOpPrec(Token::Type tt) {
   }
 }
 
+ast::ExprPtr Parser::parseExpr() { return precedenceParse(0); }
+
 ast::ExprPtr Parser::precedenceParse(int minPrec) {
-  // check precondition!
+  if (exprDepth >= maxRecursiveExprDepth) {
+    return parseDeepExpr(minPrec);
+  }
+  ++exprDepth;
   auto startPos = curTok.startPos(); // stays the same
   auto result = parseUnary();
   int opPrec;
   while ((opPrec = getOpPrec(curTok.type)) >= minPrec) {
-    auto opTok = std::move(curTok);
+    auto opType = curTok.type;
     readNextToken();
-    if (opTok.type != TT::Eq) { // only right assoc case
+    if (opType != TT::Eq) { // only right assoc case
       opPrec += 1;
     }
     auto rhs = precedenceParse(opPrec);
     auto endPos = rhs->getLoc().endToken;
-    auto operation = ast::BinaryExpression::getOpForToken(opTok.type);
-    result = ast::make_EPtr<ast::BinaryExpression>(
-        {startPos, endPos}, std::move(result), std::move(rhs), operation);
+    result = create<ast::BinaryExpression>(
+        {startPos, endPos}, result, rhs,
+        ast::BinaryExpression::getOpForToken(opType));
   }
+  --exprDepth;
   return result;
 }
 
 ast::ExprPtr Parser::parseUnary() {
-  std::deque<Token> unaries;
+  // the prefix operators wait on the operator stack, which needs no
+  // allocation after the first few expressions
+  const size_t operatorBase = operators.size();
+  while (curTok.type == TT::Bang || curTok.type == TT::Minus) {
+    operators.push_back({PendingOperator::Kind::Unary, curTok.type, 0,
+                         curTok.startPos(), nullptr, 0});
+    readNextToken();
+  }
+  TokenPos minusPos;
+  bool negativeLiteral = false;
+  if (curTok.type == TT::IntLiteral && operators.size() > operatorBase &&
+      operators.back().type == TT::Minus) {
+    minusPos = operators.back().pos;
+    negativeLiteral = true;
+    operators.pop_back();
+  }
+  auto expr = parsePostfixExpr(negativeLiteral ? &minusPos : nullptr);
+  auto endPos = expr->getLoc().endToken;
+  // consume all unary prefixes in reverse order
+  while (operators.size() > operatorBase) {
+    auto &op = operators.back();
+    expr = create<ast::UnaryExpression>(
+        {op.pos, endPos}, expr, ast::UnaryExpression::getOpForToken(op.type));
+    operators.pop_back();
+  }
+  return expr;
+}
+
+ast::ExprPtr Parser::parsePostfixExpr(const TokenPos *minusPos) {
+  ast::ExprPtr lhs;
+  if (curTok.type == TT::LParen) {
+    readNextToken();
+    lhs = parseExpr();
+    expectAndNext(TT::RParen);
+  } else if (curTok.type == TT::Identifier &&
+             lookAhead(1).type == TT::LParen) {
+    // "this.methodinvocation(args)"
+    auto callPos = curTok.startPos();
+    auto &name = *curTok.sym;
+    readNextToken();
+    readNextToken();
+    lhs = parseCall(callPos, nullptr, name);
+  } else {
+    lhs = parsePrimary(minusPos);
+  }
   while (true) {
     switch (curTok.type) {
-    case TT::Bang:
-      unaries.emplace_back(std::move(curTok));
+    case TT::Dot: {
+      auto accessPos = curTok.startPos();
       readNextToken();
-      continue; // parseUnary();
-    case TT::Minus:
-      unaries.emplace_back(std::move(curTok));
+      auto endPos = curTok.endPos();
+      auto &name = expectGetIdentAndNext(TT::Identifier);
+      if (curTok.type == TT::LParen) {
+        readNextToken();
+        lhs = parseCall(accessPos, lhs, name);
+      } else {
+        lhs = create<ast::FieldAccess>({accessPos, endPos}, lhs, name);
+      }
+      break;
+    }
+    case TT::LBracket: {
+      auto startPos = curTok.startPos();
       readNextToken();
-      continue; // parseUnary();
+      auto index = parseExpr();
+      expectAndNext(TT::RBracket);
+      auto endPos = curTok.endPos();
+      lhs = create<ast::ArrayAccess>({startPos, endPos}, lhs, index);
       break;
+    }
     default:
-      if (curTok.type == TT::IntLiteral && !unaries.empty() &&
-          unaries.back().type == TT::Minus) {
-        curTok.str = "-" + curTok.str;
-        unaries.pop_back();
-      }
-      auto expression = parsePostfixExpr();
-      auto endPos = expression->getLoc().endToken;
-      // result = ...
-      // consume all unary prefixes in reverse order
-
-      for (std::deque<Token>::reverse_iterator i = unaries.rbegin(),
-                                               end = unaries.rend();
-           i != end; ++i) {
-
-        Token t = std::move(*i);
-        auto startPos = t.startPos();
-        auto op = ast::UnaryExpression::getOpForToken(t.type);
-        expression = ast::make_EPtr<ast::UnaryExpression>(
-            {startPos, endPos}, std::move(expression), op);
-      }
-      return expression;
+      return lhs;
+    }
+  }
+}
+
+// curTok is the first token after '(', lhs is nullptr for the implicit 'this'
+ast::ExprPtr Parser::parseCall(TokenPos pos, ast::ExprPtr lhs,
+                               SymbolTable::Symbol &name) {
+  ast::ExprList args;
+  if (hasArguments()) {
+    args.push_back(parseExpr());
+    while (curTok.type == TT::Comma) {
+      readNextToken();
+      args.push_back(parseExpr());
     }
   }
+  auto endPos = curTok.endPos();
+  expectAndNext(TT::RParen);
+  SourceLocation loc{pos, endPos};
+  if (lhs == nullptr) {
+    lhs = create<ast::ThisLiteral>(loc);
+  }
+  return create<ast::MethodInvocation>(loc, lhs, name, std::move(args));
 }
 
-ast::ExprPtr Parser::parsePostfixExpr() {
-  auto lhs = parsePrimary();
+ast::ExprPtr Parser::parseDeepExpr(int minPrec) {
+  using Kind = PendingOperator::Kind;
+  const size_t operandBase = operands.size();
+  const size_t operatorBase = operators.size();
+  auto startPos = curTok.startPos(); // of the current unary expression
+  bool expectOperand = true;
   while (true) {
+    if (expectOperand) {
+      switch (curTok.type) {
+      case TT::Bang:
+      case TT::Minus:
+        operators.push_back(
+            {Kind::Unary, curTok.type, 0, curTok.startPos(), nullptr, 0});
+        readNextToken();
+        continue;
+      case TT::LParen:
+        operators.push_back({Kind::Paren, TT::LParen, 0, startPos, nullptr, 0});
+        readNextToken();
+        startPos = curTok.startPos();
+        continue;
+      case TT::Identifier:
+        if (lookAhead(1).type == TT::LParen) {
+          // "this.methodinvocation(args)"
+          auto callPos = curTok.startPos();
+          auto &name = *curTok.sym;
+          readNextToken();
+          readNextToken();
+          operands.push_back({nullptr, startPos});
+          expectOperand = beginCall(callPos, name);
+          if (expectOperand) {
+            startPos = curTok.startPos();
+          }
+          continue;
+        }
+        break;
+      default:
+        break;
+      }
+      TokenPos minusPos;
+      bool negativeLiteral = false;
+      if (curTok.type == TT::IntLiteral && operators.size() > operatorBase &&
+          operators.back().kind == Kind::Unary &&
+          operators.back().type == TT::Minus) {
+        minusPos = operators.back().pos;
+        negativeLiteral = true;
+        operators.pop_back();
+      }
+      auto primary = parsePrimary(negativeLiteral ? &minusPos : nullptr);
+      operands.push_back({primary, startPos});
+      expectOperand = false;
+      continue;
+    }
+
+    // postfix operators bind stronger than any prefix operator
     switch (curTok.type) {
-    case TT::Dot:
-      lhs = parseMemberAccess(std::move(lhs));
-      break;
+    case TT::Dot: {
+      auto accessPos = curTok.startPos();
+      readNextToken();
+      auto endPos = curTok.endPos();
+      auto &name = expectGetIdentAndNext(TT::Identifier);
+      if (curTok.type == TT::LParen) {
+        readNextToken();
+        expectOperand = beginCall(accessPos, name);
+        if (expectOperand) {
+          startPos = curTok.startPos();
+        }
+      } else {
+        auto &lhs = operands.back();
+        lhs.expr =
+            create<ast::FieldAccess>({accessPos, endPos}, lhs.expr, name);
+      }
+      continue;
+    }
     case TT::LBracket:
-      lhs = parseArrayAccess(std::move(lhs));
+      operators.push_back(
+          {Kind::Index, TT::LBracket, 0, curTok.startPos(), nullptr, 0});
+      readNextToken();
+      startPos = curTok.startPos();
+      expectOperand = true;
+      continue;
+    default:
+      break;
+    }
+
+    int opPrec = getOpPrec(curTok.type);
+    if (opPrec >= 0) {
+      // assignment is the only right associative operator
+      reduceOperators(operatorBase,
+                      curTok.type == TT::Eq ? opPrec + 1 : opPrec);
+      // outside of brackets, an operator binding less than minPrec belongs
+      // to the enclosing precedenceParse
+      if (opPrec >= minPrec || operators.size() > operatorBase) {
+        operators.push_back(
+            {Kind::Binary, curTok.type, opPrec, {}, nullptr, 0});
+        readNextToken();
+        startPos = curTok.startPos();
+        expectOperand = true;
+        continue;
+      }
+    } else {
+      // end of the innermost bracket or of the whole expression
+      reduceOperators(operatorBase, 0);
+    }
+    if (operators.size() == operatorBase) {
+      auto result = operands.back().expr;
+      operands.pop_back();
+      assert(operands.size() == operandBase);
+      (void)operandBase;
+      return result;
+    }
+    auto op = operators.back();
+    switch (op.kind) {
+    case Kind::Paren:
+      expectAndNext(TT::RParen);
+      operators.pop_back();
+      operands.back().startPos = op.pos;
+      break;
+    case Kind::Index: {
+      expectAndNext(TT::RBracket);
+      operators.pop_back();
+      auto endPos = curTok.endPos();
+      auto index = operands.back().expr;
+      operands.pop_back();
+      auto &lhs = operands.back();
+      lhs.expr = create<ast::ArrayAccess>({op.pos, endPos}, lhs.expr, index);
+      break;
+    }
+    case Kind::Call:
+      if (curTok.type == TT::Comma) {
+        readNextToken();
+        startPos = curTok.startPos();
+        expectOperand = true;
+      } else {
+        finishCall();
+      }
       break;
     default:
-      return lhs;
+      assert(false);
+    }
+  }
+}
+
+void Parser::reduceOperators(size_t operatorBase, int minPrec) {
+  using Kind = PendingOperator::Kind;
+  while (operators.size() > operatorBase) {
+    auto &op = operators.back();
+    if (op.kind == Kind::Unary) {
+      auto &operand = operands.back();
+      auto endPos = operand.expr->getLoc().endToken;
+      operand.expr = create<ast::UnaryExpression>(
+          {op.pos, endPos}, operand.expr,
+          ast::UnaryExpression::getOpForToken(op.type));
+    } else if (op.kind == Kind::Binary && op.prec >= minPrec) {
+      auto rhs = operands.back().expr;
+      operands.pop_back();
+      auto &lhs = operands.back();
+      auto endPos = rhs->getLoc().endToken;
+      lhs.expr = create<ast::BinaryExpression>(
+          {lhs.startPos, endPos}, lhs.expr, rhs,
+          ast::BinaryExpression::getOpForToken(op.type));
+    } else {
+      return;
     }
+    operators.pop_back();
+  }
+}
+
+// the object of the call is on top of the operands, curTok is the first token
+// after '('. Returns whether there are arguments to parse
+bool Parser::beginCall(TokenPos pos, SymbolTable::Symbol &name) {
+  operators.push_back({PendingOperator::Kind::Call, TT::LParen, 0, pos, &name,
+                       operands.size()});
+  if (hasArguments()) {
+    return true;
   }
+  finishCall();
+  return false;
 }
 
-ast::ExprPtr Parser::parsePrimary() {
+// curTok is the first token after the '(' of a call
+bool Parser::hasArguments() {
   switch (curTok.type) {
-  case TT::LParen: {
-    readNextToken();
-    auto expr = parseExpr();
-    expectAndNext(TT::RParen);
-    return expr;
+  case TT::Bang:
+  case TT::False:
+  case TT::Identifier:
+  case TT::IntLiteral:
+  case TT::New:
+  case TT::Null:
+  case TT::True:
+  case TT::LParen:
+  case TT::Minus:
+  case TT::This:
+    return true;
+  case TT::RParen:
+    return false;
+  default:
+    errorExpectedAnyOf({TT::Bang, TT::False, TT::Identifier, TT::IntLiteral,
+                        TT::New, TT::Null, TT::True, TT::LParen, TT::Minus,
+                        TT::This, TT::RParen});
   }
+}
+
+void Parser::finishCall() {
+  auto op = operators.back();
+  operators.pop_back();
+  auto endPos = curTok.endPos();
+  expectAndNext(TT::RParen);
+  ast::ExprList args;
+  args.reserve(operands.size() - op.firstArg);
+  for (size_t i = op.firstArg; i < operands.size(); ++i) {
+    args.push_back(operands[i].expr);
+  }
+  operands.resize(op.firstArg);
+  auto &lhs = operands.back();
+  SourceLocation loc{op.pos, endPos};
+  if (lhs.expr == nullptr) {
+    lhs.expr = create<ast::ThisLiteral>(loc);
+  }
+  lhs.expr =
+      create<ast::MethodInvocation>(loc, lhs.expr, *op.name, std::move(args));
+}
+
+ast::ExprPtr Parser::parsePrimary(const TokenPos *minusPos) {
+  switch (curTok.type) {
   case TT::False: {
     auto loc = curTok.singleTokenSrcLoc();
     readNextToken();
-    return ast::make_EPtr<ast::BoolLiteral>(loc, false);
+    return create<ast::BoolLiteral>(loc, false);
   }
   case TT::True: {
     auto loc = curTok.singleTokenSrcLoc();
     readNextToken();
-    return ast::make_EPtr<ast::BoolLiteral>(loc, true);
+    return create<ast::BoolLiteral>(loc, true);
   }
   case TT::Null: {
     auto loc = curTok.singleTokenSrcLoc();
     readNextToken();
-    return ast::make_EPtr<ast::NullLiteral>(loc);
+    return create<ast::NullLiteral>(loc);
   }
   case TT::This: {
     auto loc = curTok.singleTokenSrcLoc();
     readNextToken();
-    return ast::make_EPtr<ast::ThisLiteral>(loc);
+    return create<ast::ThisLiteral>(loc);
   }
   case TT::IntLiteral: {
-    auto loc = curTok.singleTokenSrcLoc();
-    int32_t value;
-    try {
-      value = std::stoi(curTok.str);
-    } catch (std::out_of_range &o) {
-      error("Integer literal '" + curTok.str + "' out of range");
-    } catch (std::invalid_argument &i) {
-      // should never happen!
-      throw std::runtime_error("Invalid integer literal");
+    SourceLocation loc{minusPos ? *minusPos : curTok.startPos(),
+                       curTok.endPos()};
+    bool negativeLiteral = minusPos != nullptr;
+    // the lexer only produces decimal digits, so no need for std::stoi
+    const int64_t maxValue = negativeLiteral ? 2147483648 : 2147483647;
+    int64_t value = 0;
+    for (char c : curTok.sym->name) {
+      value = value * 10 + (c - '0');
+      if (value > maxValue) {
+        error("Integer literal '"s + (negativeLiteral ? "-" : "") +
+              curTok.sym->name + "' out of range");
+      }
+    }
+    if (negativeLiteral) {
+      value = -value;
     }
     readNextToken();
-    return ast::make_EPtr<ast::IntLiteral>(loc, value);
+    return create<ast::IntLiteral>(loc, static_cast<int32_t>(value));
   }
   case TT::Identifier: {
-    auto startPos = curTok.startPos();
-    auto fieldEndPos = curTok.endPos();
-    auto ident = std::move(curTok.str);
+    // method invocations without object are handled in parseExpr
+    auto loc = curTok.singleTokenSrcLoc();
+    auto &identSym = *curTok.sym;
     readNextToken();
-    if (curTok.type == TT::LParen) {
-      // return "this.methodinvocation(args)
-      readNextToken();
-      auto args = parseArguments();
-      auto endPos = curTok.endPos();
-      expectAndNext(TT::RParen);
-      SourceLocation loc{startPos, endPos};
-      return ast::make_EPtr<ast::MethodInvocation>(
-          loc, ast::make_EPtr<ast::ThisLiteral>(loc), std::move(ident),
-          std::move(args));
-    } else {
-      SourceLocation loc{startPos, fieldEndPos};
-      return ast::make_EPtr<ast::VarRef>(loc, strTbl.findOrInsert(ident));
-    }
+    return create<ast::VarRef>(loc, identSym);
   }
   case TT::New:
     return parseNewExpr();
@@ -657,74 +907,18 @@ ast::ExprPtr Parser::parsePrimary() {
   }
 }
 
-ast::ExprPtr Parser::parseMemberAccess(ast::ExprPtr lhs) {
-  auto startPos = curTok.startPos();
-  expectAndNext(TT::Dot);
-  auto endPos = curTok.endPos();
-  auto ident = expectGetIdentAndNext(TT::Identifier);
-  if (curTok.type == TT::LParen) {
-    readNextToken();
-    auto args = parseArguments();
-    endPos = curTok.endPos();
-    expectAndNext(TT::RParen);
-    return ast::make_EPtr<ast::MethodInvocation>(
-        {startPos, endPos}, std::move(lhs), std::move(ident), std::move(args));
-  } else {
-    return ast::make_EPtr<ast::FieldAccess>({startPos, endPos}, std::move(lhs),
-                                            std::move(ident));
-  }
-}
-
-ast::ExprPtr Parser::parseArrayAccess(ast::ExprPtr lhs) {
-  auto startPos = curTok.startPos();
-  expectAndNext(TT::LBracket);
-  auto index = parseExpr();
-  expectAndNext(TT::RBracket);
-  auto endPos = curTok.endPos();
-  return ast::make_EPtr<ast::ArrayAccess>({startPos, endPos}, std::move(lhs),
-                                          std::move(index));
-}
-
-ast::ExprList Parser::parseArguments() {
-  ast::ExprList arguments;
-  switch (curTok.type) {
-  case TT::Bang:
-  case TT::False:
-  case TT::Identifier:
-  case TT::IntLiteral:
-  case TT::New:
-  case TT::Null:
-  case TT::True:
-  case TT::LParen:
-  case TT::Minus:
-  case TT::This:
-    arguments.emplace_back(parseExpr());
-    while (curTok.type == TT::Comma) {
-      readNextToken();
-      arguments.emplace_back(parseExpr());
-    }
-    return arguments;
-  case TT::RParen:
-    return arguments; // empty vector
-  default:
-    errorExpectedAnyOf({TT::Bang, TT::False, TT::Identifier, TT::IntLiteral,
-                        TT::New, TT::Null, TT::True, TT::LParen, TT::Minus,
-                        TT::This, TT::RParen});
-  }
-}
-
 ast::ExprPtr Parser::parseNewExpr() {
   auto startPos = curTok.startPos();
   expectAndNext(TT::New);
   // check next token instead of current
   switch (lookAhead(1).type) {
   case TT::LParen: {
-    auto ident = expectGetIdentAndNext(TT::Identifier);
+    auto &ident = expectGetIdentAndNext(TT::Identifier).name;
     // curTok is always LParen
     readNextToken();
     auto endPos = curTok.startPos();
     expectAndNext(TT::RParen);
-    return ast::make_EPtr<ast::NewObjectExpression>({startPos, endPos}, ident);
+    return create<ast::NewObjectExpression>({startPos, endPos}, ident);
   }
   case TT::LBracket: {
     auto elementType = parseBasicType();
@@ -735,6 +929,7 @@ ast::ExprPtr Parser::parseNewExpr() {
     expectAndNext(TT::RBracket);
     int dimension = 1;
     while (curTok.type == TT::LBracket && lookAhead(1).type == TT::RBracket) {
+      checkArrayDimension(dimension);
       dimension += 1;
       readNextToken(); // eat '['
       endPos = curTok.endPos();
@@ -742,9 +937,9 @@ ast::ExprPtr Parser::parseNewExpr() {
     }
     SourceLocation loc{startPos, endPos};
     auto arrayType =
-        ast::make_Ptr<ast::ArrayType>(loc, std::move(elementType), dimension);
-    return ast::make_EPtr<ast::NewArrayExpression>(loc, std::move(arrayType),
-                                                   std::move(size));
+        create<ast::ArrayType>(loc, std::move(elementType), dimension);
+    return create<ast::NewArrayExpression>(loc, std::move(arrayType),
+                                           std::move(size));
   }
   default:
     errorExpectedAnyOf({TT::LParen, TT::LBracket});
@@ -59,21 +59,57 @@ class Parser {
   const InputFile &inputFile;
   Lexer lexer;
   SymbolTable::StringTable &strTbl;
+  // identifiers with special meaning in the main method declaration
+  const SymbolTable::Symbol &stringSym, &throwsSym;
 
+  TokenBuffer tokens;
+  size_t curTokIdx = 0;
   Token curTok;
 
+  // all AST nodes are allocated here, it is handed over to the Program
+  Arena arena;
+
+  // Expressions are parsed by recursive descent up to a small nesting depth,
+  // which is fastest for the usual shallow expressions. Below that,
+  // parseDeepExpr takes over and parses with explicit operand and operator
+  // stacks instead of recursion, so the nesting depth is only bounded by
+  // memory. A nested parseDeepExpr (for the size of a new array) works on top
+  // of the entries of the outer one.
+  int exprDepth = 0;
+  struct PendingOperand {
+    ast::ExprPtr expr; // nullptr is the implicit 'this' of a method call
+    TokenPos startPos; // start of the unary expression containing expr
+  };
+  struct PendingOperator {
+    enum class Kind { Unary, Binary, Paren, Index, Call };
+    Kind kind;
+    Token::Type type; // Unary and Binary
+    int prec;         // Binary
+    // Unary: the operator, Paren: start of the enclosing unary expression,
+    // Index: the '[', Call: the '.' or the method name
+    TokenPos pos;
+    SymbolTable::Symbol *name; // Call
+    size_t firstArg; // Call: index of the first argument in operands
+  };
+  std::vector<PendingOperand> operands;
+  std::vector<PendingOperator> operators;
+
 public:
   Parser(const InputFile &inputFile, SymbolTable::StringTable &strTbl)
-      : inputFile(inputFile), lexer(inputFile), strTbl(strTbl) {
-    readNextToken();
-  }
+      : inputFile(inputFile), lexer(inputFile, strTbl), strTbl(strTbl),
+        stringSym(strTbl.findOrInsert("String")),
+        throwsSym(strTbl.findOrInsert("throws")),
+        tokens(lexer.readAllTokens()), curTok(tokens.get(0)) {}
 
   Token &readNextToken() {
-    curTok = lexer.nextToken();
+    curTok = tokens.get(++curTokIdx);
     return curTok;
   }
 
-  Token &lookAhead(size_t numTokens) { return lexer.lookAhead(numTokens); }
+  Token lookAhead(size_t numTokens) const {
+    assert(numTokens > 0);
+    return tokens.get(curTokIdx + numTokens);
+  }
 
   void parseFileOnly();
   void parseAndPrintAst();
@@ -84,6 +120,11 @@ public:
   Lexer &getLexer() { return lexer; }
 
 private:
+  template <typename T, typename... Args>
+  T *create(SourceLocation loc, Args &&... args) {
+    return arena.create<T>(std::move(loc), std::forward<Args>(args)...);
+  }
+
   void readExpect(Token::Type ttype) {
     readNextToken();
     //     std::cout << curTok.toStr() << std::endl;
@@ -93,9 +134,9 @@ private:
     expect(ttype);
     readNextToken();
   }
-  std::string expectGetIdentAndNext(Token::Type ttype) {
+  SymbolTable::Symbol &expectGetIdentAndNext(Token::Type ttype) {
     expect(ttype);
-    std::string res = std::move(curTok.str);
+    SymbolTable::Symbol &res = *curTok.sym;
     readNextToken();
     return res;
   }
@@ -104,7 +145,7 @@ private:
       std::stringstream errorLine;
       auto cl_err = co::make_colored(errorLine);
       cl_err << "Unexpected " << co::mode(co::bold) << '\''
-             << truncateString(curTok.str, 64) << '\'' << co::reset
+             << truncateString(curTok.str(), 64) << '\'' << co::reset
              << ", expected ";
       if (Lexer::tokenNameNeedsQuotes(ttype)) {
         cl_err << co::mode(co::bold) << '\'' << Lexer::getTokenName(ttype)
@@ -134,13 +175,19 @@ private:
     std::stringstream errorLine;
     auto cl_err = co::make_colored(errorLine);
     cl_err << "Unexpected " << co::mode(co::bold) << '\''
-           << truncateString(curTok.str, 64) << '\'' << co::reset
+           << truncateString(curTok.str(), 64) << '\'' << co::reset
            << ", expected one of " << listToString(tokens, " or ", [](auto t) {
                 return "\'"s + Lexer::getTokenName(t) + '\'';
               });
 
     error(errorLine.str());
   }
+  // sem::Type stores the dimension in 16 bits
+  void checkArrayDimension(int dimension) {
+    if (unlikely(dimension == UINT16_MAX)) {
+      error("Too many array dimensions");
+    }
+  }
   inline ast::ClassPtr parseClassDeclaration();
   inline void parseClassMember(std::vector<ast::FieldPtr> &fields,
                                std::vector<ast::RegularMethodPtr> &methods,
@@ -163,11 +210,19 @@ private:
   inline ast::ExprPtr parseExpr();
   inline ast::ExprPtr precedenceParse(int minPrec);
   inline ast::ExprPtr parseUnary();
-  inline ast::ExprPtr parsePostfixExpr();
-  inline ast::ExprPtr parsePrimary();
-  inline ast::ExprPtr parseMemberAccess(ast::ExprPtr lhs);
-  inline ast::ExprPtr parseArrayAccess(ast::ExprPtr lhs);
-  inline ast::ExprList parseArguments();
+  // minusPos: position of a unary minus to fold into the integer literal
+  inline ast::ExprPtr parsePostfixExpr(const TokenPos *minusPos);
+  inline ast::ExprPtr parseCall(TokenPos pos, ast::ExprPtr lhs,
+                                SymbolTable::Symbol &name);
+  inline bool hasArguments();
+  // parses the operand of a binary operator with minPrec like
+  // precedenceParse, but without recursion
+  inline ast::ExprPtr parseDeepExpr(int minPrec);
+  inline void reduceOperators(size_t operatorBase, int minPrec);
+  inline bool beginCall(TokenPos pos, SymbolTable::Symbol &name);
+  inline void finishCall();
+  // minusPos: position of a unary minus to fold into the integer literal
+  inline ast::ExprPtr parsePrimary(const TokenPos *minusPos = nullptr);
   inline ast::ExprPtr parseNewExpr();
 };
 
@@ -1,14 +1,120 @@
 #include "semantic_visitor.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
 ast::DummyDefinition SemanticVisitor::dummyMainArgDef;
 
+static std::mutex lexerMutex;
+
+std::string SemanticVisitor::getInputLine(int line) {
+  std::lock_guard<std::mutex> lock(lexerMutex);
+  return lexer.getCurrentLineFromInput(line);
+}
+
+// fills the class and member lookup tables before any method body is checked,
+// those may refer to members of classes that come later
+void SemanticVisitor::collectDeclarations(ast::Program &program) {
+  for (auto *cls : program.getClasses()) {
+    if (program.addClass(cls)) {
+      error(*cls, "invalid duplicate definition of class");
+    }
+  }
+  for (auto *cls : program.getClasses()) {
+    for (auto *field : cls->getFields()->fields) {
+      if (cls->addField(field)) {
+        error(*field, "invalid duplicate definition of field");
+      }
+    }
+    for (auto *method : cls->getMethods()->methods) {
+      if (cls->addMethod(method)) {
+        error(*method, "invalid duplicate definition of method");
+      }
+      methodJobs.push_back({cls, method});
+    }
+    for (auto *method : cls->getMainMethods()->mainMethods) {
+      methodJobs.push_back({cls, method});
+    }
+  }
+  // in source order, errors are reported for the first failing method
+  std::sort(methodJobs.begin(), methodJobs.end(),
+            [](const MethodJob &a, const MethodJob &b) {
+              auto &posA = a.method->getLoc().startToken;
+              auto &posB = b.method->getLoc().startToken;
+              return std::tie(posA.line, posA.col) <
+                     std::tie(posB.line, posB.col);
+            });
+}
+
+// threads only pay off for programs with many methods
+static unsigned numSemanticThreads(size_t numMethods) {
+  constexpr size_t minParallelMethods = 1024;
+  unsigned numThreads = 1;
+  if (const char *threads = std::getenv("MJC_SEMA_THREADS")) {
+    numThreads = std::atoi(threads);
+  } else if (numMethods >= minParallelMethods) {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  return std::max(1u, std::min<unsigned>(numThreads, numMethods));
+}
+
+// Method bodies only depend on the declarations, so they are checked in
+// parallel, each thread with its own visitor and SymbolTable. A thread stops
+// at its first error. The error of the first failing method in source order
+// is reported, so the result does not depend on the scheduling: all methods
+// before it are always checked completely.
+void SemanticVisitor::checkMethodBodies() {
+  size_t numJobs = methodJobs.size();
+  std::vector<std::exception_ptr> errors(numJobs);
+  std::atomic<size_t> nextJob{0};
+  std::atomic<size_t> firstError{numJobs};
+
+  auto work = [&] {
+    SemanticVisitor visitor(lexer);
+    visitor.currentProgram = currentProgram;
+    size_t i;
+    while ((i = nextJob++) < firstError) {
+      try {
+        visitor.checkMethod(methodJobs[i]);
+      } catch (...) {
+        errors[i] = std::current_exception();
+        size_t prev = firstError;
+        while (i < prev && !firstError.compare_exchange_weak(prev, i)) {
+        }
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned t = 1; t < numSemanticThreads(numJobs); ++t) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  if (firstError < numJobs) {
+    std::rethrow_exception(errors[firstError]);
+  }
+}
+
+void SemanticVisitor::checkMethod(const MethodJob &job) {
+  currentClass = job.klass;
+  job.method->accept(this);
+}
+
 void SemanticVisitor::visitProgram(ast::Program &program) {
   currentProgram = &program;
-  checkForDuplicates(program.getClasses(), "class");
-  for (auto &cls : program.getClasses()) {
-    cls->sortMembers();
-  }
+  collectDeclarations(program);
   program.acceptChildren(this);
+  checkMethodBodies();
 
   if (this->mainMethodCount == 0) {
     error(program, "Program does not contain a valid main method", true);
@@ -22,12 +128,10 @@ void SemanticVisitor::visitClass(ast::Class &klass) {
   auto &mainMethods = klass.getMainMethods()->mainMethods;
 
   currentClass = &klass;
-  symTbl.enterScope(); // for the fields
   klass.acceptChildren(this);
-  symTbl.leaveScope(); // for the fields
 
   if (mainMethods.size() > 0) {
-    auto overload = findMethodInClass(currentClass, mainMethods[0]->getName());
+    auto overload = klass.findMethod(mainMethods[0]->getSymbol());
     if (overload) {
       error(*overload, "may not overload main method");
     }
@@ -35,16 +139,11 @@ void SemanticVisitor::visitClass(ast::Class &klass) {
 }
 
 void SemanticVisitor::visitFieldList(ast::FieldList &fieldList) {
-  checkForDuplicates(fieldList.fields, "field");
-  for (auto &f : fieldList.fields) {
-    symTbl.insert(f->getSymbol(), f.get());
-  }
   fieldList.acceptChildren(this);
 }
 
-void SemanticVisitor::visitMethodList(ast::MethodList &methodList) {
-  checkForDuplicates(methodList.methods, "method");
-  methodList.acceptChildren(this);
+void SemanticVisitor::visitMethodList(ast::MethodList &) {
+  // the bodies are checked in checkMethodBodies
 }
 
 void SemanticVisitor::visitMainMethodList(ast::MainMethodList &mainMethodList) {
@@ -52,20 +151,22 @@ void SemanticVisitor::visitMainMethodList(ast::MainMethodList &mainMethodList) {
     error(*mainMethodList.mainMethods[1],
           "Not more than one main method allowed per class");
   }
-  mainMethodList.acceptChildren(this);
+  // the bodies are checked in checkMethodBodies
+  for (auto *mm : mainMethodList.mainMethods) {
+    if (mm->getName() == "main") {
+      this->mainMethodCount += 1;
+    }
+  }
 }
 
 void SemanticVisitor::visitMainMethod(ast::MainMethod &mm) {
+  symTbl.enterScope(); // for the parameter
   currentMethod = &mm;
   currentLocalVarDeclNr = 0;
   symTbl.insert(mm.getArgSymbol(), &dummyMainArgDef);
   mm.acceptChildren(this);
+  symTbl.leaveScope();
   currentMethod = nullptr;
-
-  if (mm.getName() == "main") {
-    this->mainMethodCount += 1;
-  }
-  // INFO: check for >1 "main"-methods already done in visitMainMethodList
 }
 
 void SemanticVisitor::visitRegularMethod(ast::RegularMethod &method) {
@@ -139,9 +240,31 @@ void SemanticVisitor::visitVariableDeclaration(ast::VariableDeclaration &decl) {
   }
 }
 
+void SemanticVisitor::visitExpression(ast::Expression &expr) {
+  // Expressions are checked bottom up with an explicit stack, so their
+  // nesting depth is not limited by the call stack. The visit methods of
+  // expressions therefore only check the node itself. A nullptr marks that
+  // the children of the expression below it have been visited.
+  exprStack.push_back(&expr);
+  while (!exprStack.empty()) {
+    auto *e = exprStack.back();
+    if (e == nullptr) {
+      exprStack.pop_back();
+      exprStack.back()->accept(this);
+      exprStack.pop_back();
+    } else {
+      exprStack.push_back(nullptr);
+      e->expandChildren(this, exprStack);
+    }
+  }
+}
+
 void SemanticVisitor::visitVarRef(ast::VarRef &varRef) {
-  varRef.acceptChildren(this);
-  auto *def = symTbl.lookup(varRef.getSymbol());
+  // fields are not in the SymbolTable, locals and parameters shadow them
+  SymbolTable::Definition *def = symTbl.lookup(varRef.getSymbol());
+  if (!def) {
+    def = currentClass->findField(varRef.getSymbol());
+  }
   if (!def) {
     if (varRef.getName() == "System") {
       def = &ast::VarRef::dummySystem;
@@ -181,19 +304,18 @@ void SemanticVisitor::visitParameter(ast::Parameter &param) {
 }
 
 void SemanticVisitor::visitNewObjectExpression(ast::NewObjectExpression &expr) {
-  expr.acceptChildren(this);
-  auto *def = findClassByName(expr.getName());
+  auto *def = currentProgram->findClass(expr.getClassId());
   if (!def) {
     error(expr, "Undefined class '" + expr.getName() + "'");
   }
   expr.setDef(def);
 
-  expr.targetType.setClass(expr.getName());
+  expr.targetType.setClass(expr.getClassId());
 }
 
 void SemanticVisitor::visitClassType(ast::ClassType &type) {
   type.acceptChildren(this);
-  auto *def = findClassByName(type.getName());
+  auto *def = currentProgram->findClass(type.getClassId());
   if (!def) {
     error(type, "Undefined class '" + type.getName() + "'");
   }
@@ -214,15 +336,13 @@ void SemanticVisitor::visitThisLiteral(ast::ThisLiteral &lit) {
     error(lit, "'this' may not be used outside of classes");
   }
   if (dynamic_cast<ast::RegularMethod *>(currentMethod)) {
-    lit.targetType.setClass(this->currentClass->getName());
+    lit.targetType.setClass(this->currentClass->getClassId());
   } else {
     error(lit, "Cannot access class members in static method");
   }
 }
 
 void SemanticVisitor::visitBinaryExpression(ast::BinaryExpression &expr) {
-  expr.acceptChildren(this);
-
   auto left = expr.getLeft();
   auto right = expr.getRight();
 
@@ -290,8 +410,6 @@ void SemanticVisitor::visitBinaryExpression(ast::BinaryExpression &expr) {
 }
 
 void SemanticVisitor::visitNewArrayExpression(ast::NewArrayExpression &expr) {
-  expr.acceptChildren(this);
-
   if (!expr.getSize()->targetType.isInt()) {
     error(*expr.getSize(), "Array indices must be ints");
   }
@@ -306,8 +424,6 @@ void SemanticVisitor::visitNewArrayExpression(ast::NewArrayExpression &expr) {
 }
 
 void SemanticVisitor::visitFieldAccess(ast::FieldAccess &access) {
-  access.acceptChildren(this);
-
   // special handling for System.out.println()
   if (auto ref = dynamic_cast<ast::VarRef *>(access.getLeft())) {
     if (ref->getDef() == &ast::VarRef::dummySystem) {
@@ -339,21 +455,19 @@ void SemanticVisitor::visitFieldAccess(ast::FieldAccess &access) {
     error(*access.getLeft(), msg.str());
   }
 
-  auto cls = findClassByName(lhsType.name);
+  auto cls = currentProgram->findClass(lhsType.classId);
   assert(cls);
-  auto &fieldName = access.getName();
-  auto field = findFieldInClass(cls, fieldName);
+  auto field = cls->findField(access.getSymbol());
   if (!field) {
     error(access,
-          "Unknown field " + access.getName() + " in class " + lhsType.name);
+          "Unknown field " + access.getName() + " in class " +
+              lhsType.getClassName());
   }
   access.setDef(field);
   access.targetType = field->getType()->getSemaType();
 }
 
 void SemanticVisitor::visitMethodInvocation(ast::MethodInvocation &invocation) {
-  invocation.acceptChildren(this);
-
   // special handling for System.out.println()
   if (auto left = dynamic_cast<ast::VarRef *>(invocation.getLeft())) {
     auto *def = left->getDef();
@@ -363,13 +477,12 @@ void SemanticVisitor::visitMethodInvocation(ast::MethodInvocation &invocation) {
     }
     auto defSemaType = def->getType()->getSemaType();
     if (defSemaType.kind == sem::TypeKind::Class) {
-      auto *classDef = findClassByName(defSemaType.name);
+      auto *classDef = currentProgram->findClass(defSemaType.classId);
       assert(classDef != nullptr);
 
-      ast::RegularMethod *method =
-          findMethodInClass(classDef, invocation.getName());
+      ast::RegularMethod *method = classDef->findMethod(invocation.getSymbol());
       if (method == nullptr) {
-        error(invocation, "Class " + defSemaType.name +
+        error(invocation, "Class " + defSemaType.getClassName() +
                               " does not contain a method " +
                               invocation.getName());
       }
@@ -448,10 +561,8 @@ void SemanticVisitor::visitMethodInvocation(ast::MethodInvocation &invocation) {
   if (!left->targetType.isClass()) {
     error(invocation, "Methods can only be called on class types");
   }
-  auto className = left->targetType.name;
-  auto classDef = findClassByName(className);
-  ast::RegularMethod *method =
-      findMethodInClass(classDef, invocation.getName());
+  auto classDef = currentProgram->findClass(left->targetType.classId);
+  ast::RegularMethod *method = classDef->findMethod(invocation.getSymbol());
   if (method == nullptr) {
     error(invocation, "Class " + currentClass->getName() +
                           " does not have a method called '" +
@@ -549,8 +660,6 @@ void SemanticVisitor::visitReturnStatement(ast::ReturnStatement &stmt) {
 }
 
 void SemanticVisitor::visitUnaryExpression(ast::UnaryExpression &expr) {
-  expr.acceptChildren(this);
-
   auto inner = expr.getExpression();
 
   if (expr.getOperation() == ast::UnaryExpression::Op::Neg) {
@@ -573,8 +682,6 @@ void SemanticVisitor::visitUnaryExpression(ast::UnaryExpression &expr) {
 }
 
 void SemanticVisitor::visitArrayAccess(ast::ArrayAccess &access) {
-  access.acceptChildren(this);
-
   if (!access.getIndex()->targetType.isInt()) {
     std::stringstream msg;
     msg << "Array indices must be integer expressions, but have "
@@ -590,12 +697,7 @@ void SemanticVisitor::visitArrayAccess(ast::ArrayAccess &access) {
   }
 
   // access.targetType is array type -> decrease dimension by one
-  access.targetType = access.getArray()->targetType;
-  access.targetType.dimension -= 1;
-  if (access.targetType.dimension == 0) {
-    // array no more -> inner type surfaces
-    access.targetType.kind = access.targetType.innerKind;
-  }
+  access.targetType = access.getArray()->targetType.getArrayInnerType();
 }
 
 void SemanticVisitor::visitField(ast::Field &field) {
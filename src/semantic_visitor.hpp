@@ -5,8 +5,6 @@
 #include "error.hpp"
 #include "symboltable.hpp"
 
-#include <algorithm>
-
 class SemanticVisitor : public ast::Visitor {
   ast::Program *currentProgram = nullptr;
   ast::Class *currentClass = nullptr;
@@ -14,40 +12,17 @@ class SemanticVisitor : public ast::Visitor {
   int currentLocalVarDeclNr = 0;
   int mainMethodCount = 0;
   SymbolTable::SymbolTable symTbl;
+  // expressions still to visit, see visitExpression
+  std::vector<ast::Expression *> exprStack;
 
-  static ast::DummyDefinition dummyMainArgDef;
+  // method bodies are checked after all declarations, see checkMethodBodies
+  struct MethodJob {
+    ast::Class *klass;
+    ast::Method *method;
+  };
+  std::vector<MethodJob> methodJobs;
 
-  ast::Class *findClassByName(const std::string &className) {
-    return currentProgram->findClassByName(className);
-  }
-
-  ast::RegularMethod *findMethodInClass(ast::Class *klass,
-                                        const std::string &methodName) {
-    auto &methods = klass->getMethods()->methods;
-    auto pos = std::lower_bound(
-        methods.begin(), methods.end(), methodName,
-        [](const ast::RegularMethodPtr &m, const std::string &str) {
-          return m->getName() < str;
-        });
-    if ((pos == methods.end()) || (methodName < (*pos)->getName())) {
-      return nullptr;
-    }
-    return pos->get();
-  }
-
-  ast::Field *findFieldInClass(ast::Class *klass,
-                               const std::string &fieldName) {
-    auto &fields = klass->getFields()->fields;
-    auto pos =
-        std::lower_bound(fields.begin(), fields.end(), fieldName,
-                         [](const ast::FieldPtr &f, const std::string &str) {
-                           return f->getName() < str;
-                         });
-    if ((pos == fields.end()) || (fieldName < (*pos)->getName())) {
-      return nullptr;
-    }
-    return pos->get();
-  }
+  static ast::DummyDefinition dummyMainArgDef;
 
   Lexer &lexer;
 
@@ -80,35 +55,29 @@ public:
   void visitFieldAccess(ast::FieldAccess &access) override;
   void visitUnaryExpression(ast::UnaryExpression &expr) override;
   void visitArrayAccess(ast::ArrayAccess &access) override;
+  void visitExpression(ast::Expression &expr) override;
 
   virtual ~SemanticVisitor() {}
 
 private:
-  template <typename T>
-  void checkForDuplicates(T &list, const std::string &name) {
-    std::stable_sort(list.begin(), list.end(), ast::SortUniquePtrPred());
-    auto firstDuplicate =
-        std::adjacent_find(list.begin(), list.end(), ast::UniquePtrEqPred());
-    if (firstDuplicate != list.end()) {
-      error(**++firstDuplicate, "invalid duplicate definition of " + name);
-      // first defition is at **firstDuplicate
-    }
-  }
+  void collectDeclarations(ast::Program &program);
+  void checkMethodBodies();
+  void checkMethod(const MethodJob &job);
+  // the lexer is shared by all threads checking method bodies
+  std::string getInputLine(int line);
 
   [[noreturn]] void error(const ast::Node &node, std::string msg,
                           bool reportAtScopeEnd = false) {
     auto &loc = node.getLoc();
     auto &errorToken = reportAtScopeEnd ? loc.endToken : loc.startToken;
     throw ast::SemanticError(loc, lexer.getFilename(), std::move(msg),
-                             lexer.getCurrentLineFromInput(errorToken.line),
-                             reportAtScopeEnd);
+                             getInputLine(errorToken.line), reportAtScopeEnd);
   }
   [[noreturn]] void error(SourceLocation loc, std::string msg,
                           bool reportAtScopeEnd = false) {
     auto &errorToken = reportAtScopeEnd ? loc.endToken : loc.startToken;
     throw ast::SemanticError(loc, lexer.getFilename(), std::move(msg),
-                             lexer.getCurrentLineFromInput(errorToken.line),
-                             reportAtScopeEnd);
+                             getInputLine(errorToken.line), reportAtScopeEnd);
   }
 };
 
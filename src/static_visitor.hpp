@@ -0,0 +1,325 @@
+#ifndef STATIC_VISITOR_H
+#define STATIC_VISITOR_H
+
+#include "ast.hpp"
+
+namespace ast {
+
+// Visitor dispatching on Node::getKind instead of accept and virtual visit
+// methods. A pass derives from StaticVisitor<Pass> and hides the visitX
+// methods it is interested in. All calls go through derived(), so they are
+// resolved at compile time and can be inlined across node types.
+//
+// The default visitX methods call visitChildren, which traverses the
+// children in the same order as Node::acceptChildren. Like with Visitor,
+// statements hand their expressions to visitExpression, subexpressions are
+// visited directly.
+template <typename Derived> class StaticVisitor {
+protected:
+  Derived &derived() { return *static_cast<Derived *>(this); }
+
+public:
+  // Dispatches on the kind of the node. The overloads for the node
+  // categories only switch over the kinds in that category, so each of them
+  // stays small and the branch predictor gets a separate jump per category.
+  void visit(Node &node) {
+    switch (node.getKind()) {
+    case NodeKind::Program:
+      return derived().visitProgram(static_cast<Program &>(node));
+    case NodeKind::Class:
+      return derived().visitClass(static_cast<Class &>(node));
+    case NodeKind::FieldList:
+      return derived().visitFieldList(static_cast<FieldList &>(node));
+    case NodeKind::MethodList:
+      return derived().visitMethodList(static_cast<MethodList &>(node));
+    case NodeKind::MainMethodList:
+      return derived().visitMainMethodList(
+          static_cast<MainMethodList &>(node));
+    case NodeKind::Field:
+      return derived().visitField(static_cast<Field &>(node));
+    case NodeKind::RegularMethod:
+      return derived().visitRegularMethod(static_cast<RegularMethod &>(node));
+    case NodeKind::MainMethod:
+      return derived().visitMainMethod(static_cast<MainMethod &>(node));
+    case NodeKind::Parameter:
+      return derived().visitParameter(static_cast<Parameter &>(node));
+    case NodeKind::PrimitiveType:
+      return derived().visitPrimitiveType(static_cast<PrimitiveType &>(node));
+    case NodeKind::ClassType:
+      return derived().visitClassType(static_cast<ClassType &>(node));
+    case NodeKind::ArrayType:
+      return derived().visitArrayType(static_cast<ArrayType &>(node));
+    case NodeKind::Block:
+      return derived().visitBlock(static_cast<Block &>(node));
+    case NodeKind::VariableDeclaration:
+      return derived().visitVariableDeclaration(
+          static_cast<VariableDeclaration &>(node));
+    case NodeKind::ExpressionStatement:
+      return derived().visitExpressionStatement(
+          static_cast<ExpressionStatement &>(node));
+    case NodeKind::IfStatement:
+      return derived().visitIfStatement(static_cast<IfStatement &>(node));
+    case NodeKind::WhileStatement:
+      return derived().visitWhileStatement(
+          static_cast<WhileStatement &>(node));
+    case NodeKind::ReturnStatement:
+      return derived().visitReturnStatement(
+          static_cast<ReturnStatement &>(node));
+    case NodeKind::NewArrayExpression:
+      return derived().visitNewArrayExpression(
+          static_cast<NewArrayExpression &>(node));
+    case NodeKind::NewObjectExpression:
+      return derived().visitNewObjectExpression(
+          static_cast<NewObjectExpression &>(node));
+    case NodeKind::IntLiteral:
+      return derived().visitIntLiteral(static_cast<IntLiteral &>(node));
+    case NodeKind::BoolLiteral:
+      return derived().visitBoolLiteral(static_cast<BoolLiteral &>(node));
+    case NodeKind::NullLiteral:
+      return derived().visitNullLiteral(static_cast<NullLiteral &>(node));
+    case NodeKind::ThisLiteral:
+      return derived().visitThisLiteral(static_cast<ThisLiteral &>(node));
+    case NodeKind::VarRef:
+      return derived().visitVarRef(static_cast<VarRef &>(node));
+    case NodeKind::MethodInvocation:
+      return derived().visitMethodInvocation(
+          static_cast<MethodInvocation &>(node));
+    case NodeKind::FieldAccess:
+      return derived().visitFieldAccess(static_cast<FieldAccess &>(node));
+    case NodeKind::ArrayAccess:
+      return derived().visitArrayAccess(static_cast<ArrayAccess &>(node));
+    case NodeKind::BinaryExpression:
+      return derived().visitBinaryExpression(
+          static_cast<BinaryExpression &>(node));
+    case NodeKind::UnaryExpression:
+      return derived().visitUnaryExpression(
+          static_cast<UnaryExpression &>(node));
+    }
+    __builtin_trap();
+  }
+
+  void visit(Type &node) {
+    switch (node.getKind()) {
+    case NodeKind::PrimitiveType:
+      return derived().visitPrimitiveType(static_cast<PrimitiveType &>(node));
+    case NodeKind::ClassType:
+      return derived().visitClassType(static_cast<ClassType &>(node));
+    case NodeKind::ArrayType:
+      return derived().visitArrayType(static_cast<ArrayType &>(node));
+    default:
+      __builtin_trap();
+    }
+  }
+  void visit(BlockStatement &node) {
+    switch (node.getKind()) {
+    case NodeKind::Block:
+      return derived().visitBlock(static_cast<Block &>(node));
+    case NodeKind::VariableDeclaration:
+      return derived().visitVariableDeclaration(
+          static_cast<VariableDeclaration &>(node));
+    case NodeKind::ExpressionStatement:
+      return derived().visitExpressionStatement(
+          static_cast<ExpressionStatement &>(node));
+    case NodeKind::IfStatement:
+      return derived().visitIfStatement(static_cast<IfStatement &>(node));
+    case NodeKind::WhileStatement:
+      return derived().visitWhileStatement(
+          static_cast<WhileStatement &>(node));
+    case NodeKind::ReturnStatement:
+      return derived().visitReturnStatement(
+          static_cast<ReturnStatement &>(node));
+    default:
+      __builtin_trap();
+    }
+  }
+  void visit(Expression &node) {
+    switch (node.getKind()) {
+    case NodeKind::NewArrayExpression:
+      return derived().visitNewArrayExpression(
+          static_cast<NewArrayExpression &>(node));
+    case NodeKind::NewObjectExpression:
+      return derived().visitNewObjectExpression(
+          static_cast<NewObjectExpression &>(node));
+    case NodeKind::IntLiteral:
+      return derived().visitIntLiteral(static_cast<IntLiteral &>(node));
+    case NodeKind::BoolLiteral:
+      return derived().visitBoolLiteral(static_cast<BoolLiteral &>(node));
+    case NodeKind::NullLiteral:
+      return derived().visitNullLiteral(static_cast<NullLiteral &>(node));
+    case NodeKind::ThisLiteral:
+      return derived().visitThisLiteral(static_cast<ThisLiteral &>(node));
+    case NodeKind::VarRef:
+      return derived().visitVarRef(static_cast<VarRef &>(node));
+    case NodeKind::MethodInvocation:
+      return derived().visitMethodInvocation(
+          static_cast<MethodInvocation &>(node));
+    case NodeKind::FieldAccess:
+      return derived().visitFieldAccess(static_cast<FieldAccess &>(node));
+    case NodeKind::ArrayAccess:
+      return derived().visitArrayAccess(static_cast<ArrayAccess &>(node));
+    case NodeKind::BinaryExpression:
+      return derived().visitBinaryExpression(
+          static_cast<BinaryExpression &>(node));
+    case NodeKind::UnaryExpression:
+      return derived().visitUnaryExpression(
+          static_cast<UnaryExpression &>(node));
+    default:
+      __builtin_trap();
+    }
+  }
+
+  void visitProgram(Program &program) { visitChildren(program); }
+  void visitClass(Class &klass) { visitChildren(klass); }
+  void visitFieldList(FieldList &fieldList) { visitChildren(fieldList); }
+  void visitMethodList(MethodList &methodList) { visitChildren(methodList); }
+  void visitMainMethodList(MainMethodList &mainMethodList) {
+    visitChildren(mainMethodList);
+  }
+  void visitField(Field &field) { visitChildren(field); }
+  void visitRegularMethod(RegularMethod &method) { visitChildren(method); }
+  void visitMainMethod(MainMethod &mainMethod) { visitChildren(mainMethod); }
+  void visitParameter(Parameter &parameter) { visitChildren(parameter); }
+  void visitPrimitiveType(PrimitiveType &) {}
+  void visitClassType(ClassType &) {}
+  void visitArrayType(ArrayType &arrayType) { visitChildren(arrayType); }
+  void visitBlock(Block &block) { visitChildren(block); }
+  void visitVariableDeclaration(VariableDeclaration &decl) {
+    visitChildren(decl);
+  }
+  void visitExpressionStatement(ExpressionStatement &stmt) {
+    visitChildren(stmt);
+  }
+  void visitIfStatement(IfStatement &stmt) { visitChildren(stmt); }
+  void visitWhileStatement(WhileStatement &stmt) { visitChildren(stmt); }
+  void visitReturnStatement(ReturnStatement &stmt) { visitChildren(stmt); }
+  void visitNewArrayExpression(NewArrayExpression &expr) {
+    visitChildren(expr);
+  }
+  void visitNewObjectExpression(NewObjectExpression &) {}
+  void visitIntLiteral(IntLiteral &) {}
+  void visitBoolLiteral(BoolLiteral &) {}
+  void visitNullLiteral(NullLiteral &) {}
+  void visitThisLiteral(ThisLiteral &) {}
+  void visitVarRef(VarRef &) {}
+  void visitMethodInvocation(MethodInvocation &invocation) {
+    visitChildren(invocation);
+  }
+  void visitFieldAccess(FieldAccess &access) { visitChildren(access); }
+  void visitArrayAccess(ArrayAccess &access) { visitChildren(access); }
+  void visitBinaryExpression(BinaryExpression &expr) { visitChildren(expr); }
+  void visitUnaryExpression(UnaryExpression &expr) { visitChildren(expr); }
+  // called by statements for their expressions, see Visitor::visitExpression
+  void visitExpression(Expression &expr) { derived().visit(expr); }
+
+protected:
+  void visitChildren(Program &program) {
+    auto &classes = program.getClasses();
+    std::sort(classes.begin(), classes.end(), SortPtrPred());
+    for (auto *klass : classes) {
+      derived().visitClass(*klass);
+    }
+  }
+  void visitChildren(Class &klass) {
+    derived().visitFieldList(*klass.getFields());
+    derived().visitMethodList(*klass.getMethods());
+    derived().visitMainMethodList(*klass.getMainMethods());
+  }
+  void visitChildren(FieldList &fieldList) {
+    auto &fields = fieldList.fields;
+    std::sort(fields.begin(), fields.end(), SortPtrPred());
+    for (auto *field : fields) {
+      derived().visitField(*field);
+    }
+  }
+  void visitChildren(MethodList &methodList) {
+    auto &methods = methodList.methods;
+    std::sort(methods.begin(), methods.end(), SortPtrPred());
+    for (auto *method : methods) {
+      derived().visitRegularMethod(*method);
+    }
+  }
+  void visitChildren(MainMethodList &mainMethodList) {
+    auto &mainMethods = mainMethodList.mainMethods;
+    std::sort(mainMethods.begin(), mainMethods.end(), SortPtrPred());
+    for (auto *mainMethod : mainMethods) {
+      derived().visitMainMethod(*mainMethod);
+    }
+  }
+  void visitChildren(Field &field) { derived().visit(*field.getType()); }
+  void visitChildren(RegularMethod &method) {
+    derived().visit(*method.getReturnType());
+    for (auto *param : method.getParameters()) {
+      derived().visitParameter(*param);
+    }
+    derived().visitBlock(*method.getBlock());
+  }
+  void visitChildren(MainMethod &mainMethod) {
+    derived().visitBlock(*mainMethod.getBlock());
+  }
+  void visitChildren(Parameter &parameter) {
+    derived().visit(*parameter.getType());
+  }
+  void visitChildren(ArrayType &arrayType) {
+    derived().visit(*arrayType.getElementType());
+  }
+  void visitChildren(Block &block) {
+    for (auto *stmt : block.getStatements()) {
+      if (stmt != nullptr)
+        derived().visit(*stmt);
+    }
+  }
+  void visitChildren(VariableDeclaration &decl) {
+    derived().visit(*decl.getType());
+    if (decl.getInitializer() != nullptr)
+      derived().visitExpression(*decl.getInitializer());
+  }
+  void visitChildren(ExpressionStatement &stmt) {
+    derived().visitExpression(*stmt.getExpression());
+  }
+  void visitChildren(IfStatement &stmt) {
+    derived().visitExpression(*stmt.getCondition());
+    if (stmt.getThenStatement() != nullptr)
+      derived().visit(*stmt.getThenStatement());
+    if (stmt.getElseStatement() != nullptr)
+      derived().visit(*stmt.getElseStatement());
+  }
+  void visitChildren(WhileStatement &stmt) {
+    derived().visitExpression(*stmt.getCondition());
+    if (stmt.getStatement() != nullptr)
+      derived().visit(*stmt.getStatement());
+  }
+  void visitChildren(ReturnStatement &stmt) {
+    if (stmt.getExpression() != nullptr)
+      derived().visitExpression(*stmt.getExpression());
+  }
+  void visitChildren(NewArrayExpression &expr) {
+    derived().visitArrayType(*expr.getArrayType());
+    derived().visit(*expr.getSize());
+  }
+  void visitChildren(MethodInvocation &invocation) {
+    if (invocation.getLeft() != nullptr)
+      derived().visit(*invocation.getLeft());
+    for (auto *arg : invocation.getArguments()) {
+      derived().visit(*arg);
+    }
+  }
+  void visitChildren(FieldAccess &access) {
+    if (access.getLeft() != nullptr)
+      derived().visit(*access.getLeft());
+  }
+  void visitChildren(ArrayAccess &access) {
+    derived().visit(*access.getArray());
+    derived().visit(*access.getIndex());
+  }
+  void visitChildren(BinaryExpression &expr) {
+    derived().visit(*expr.getLeft());
+    derived().visit(*expr.getRight());
+  }
+  void visitChildren(UnaryExpression &expr) {
+    derived().visit(*expr.getExpression());
+  }
+};
+
+} // namespace ast
+
+#endif // STATIC_VISITOR_H
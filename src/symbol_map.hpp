@@ -0,0 +1,91 @@
+#ifndef SYMBOL_MAP_H
+#define SYMBOL_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "symboltable.hpp"
+
+// Hash map from symbols to T*, using open addressing with linear probing.
+// Every name has exactly one Symbol, so the symbol's address serves as key
+// and lookups never compare strings. Meant to be filled once and then only
+// read, entries can't be removed.
+template <typename T> class SymbolMap {
+  struct Slot {
+    const SymbolTable::Symbol *key;
+    T *value;
+  };
+
+  // size is zero or a power of two, at most half of the slots are used
+  std::vector<Slot> slots;
+  size_t numEntries = 0;
+  unsigned shift = 64;
+
+  size_t slotIndex(const SymbolTable::Symbol *key) const {
+    // fibonacci hashing, the top bits of the product are well mixed
+    auto hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key));
+    return (hash * UINT64_C(0x9e3779b97f4a7c15)) >> shift;
+  }
+
+  void rehash(size_t newSize) {
+    std::vector<Slot> old(newSize, Slot{nullptr, nullptr});
+    old.swap(slots);
+    shift = 64;
+    for (size_t size = newSize; size > 1; size >>= 1) {
+      --shift;
+    }
+    for (auto &slot : old) {
+      if (slot.key) {
+        slots[findSlot(slot.key)] = slot;
+      }
+    }
+  }
+
+  // index of the slot holding key, or of the empty slot where it belongs
+  size_t findSlot(const SymbolTable::Symbol *key) const {
+    size_t mask = slots.size() - 1;
+    size_t i = slotIndex(key);
+    while (slots[i].key && slots[i].key != key) {
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+public:
+  void reserve(size_t count) {
+    size_t size = 8;
+    while (size < 2 * count) {
+      size *= 2;
+    }
+    if (size > slots.size()) {
+      rehash(size);
+    }
+  }
+
+  // adds sym -> value, unless sym is already present. Returns the previous
+  // value in that case and nullptr otherwise
+  T *insert(const SymbolTable::Symbol &sym, T *value) {
+    if (2 * (numEntries + 1) > slots.size()) {
+      rehash(slots.empty() ? 8 : 2 * slots.size());
+    }
+    auto &slot = slots[findSlot(&sym)];
+    if (slot.key) {
+      return slot.value;
+    }
+    slot = {&sym, value};
+    ++numEntries;
+    return nullptr;
+  }
+
+  T *find(const SymbolTable::Symbol &sym) const {
+    if (slots.empty()) {
+      return nullptr;
+    }
+    return slots[findSlot(&sym)].value;
+  }
+
+  size_t size() const { return numEntries; }
+};
+
+#endif // SYMBOL_MAP_H
@@ -24,33 +24,68 @@
  */
 
 #include "symboltable.hpp"
-#include <deque>
-#include <memory>
+
+#include <cassert>
 
 namespace SymbolTable {
 
-void SymbolTable::insert(Symbol &sym, Definition *def) {
-  changes.emplace_back(new Change(sym, def, currentScope.get()));
+StringTable::StringTable() : slots(1024, Slot{0, nullptr}), shift(64 - 10) {}
+
+StringTable::~StringTable() {
+  // the arena only releases the memory
+  for (auto &slot : slots) {
+    if (slot.sym) {
+      slot.sym->~Symbol();
+    }
+  }
+}
+
+void StringTable::grow() {
+  std::vector<Slot> old(2 * slots.size(), Slot{0, nullptr});
+  old.swap(slots);
+  --shift;
+  size_t mask = slots.size() - 1;
+  for (auto &slot : old) {
+    if (slot.sym) {
+      size_t i = slotIndex(slot.hash);
+      while (slots[i].sym) {
+        i = (i + 1) & mask;
+      }
+      slots[i] = slot;
+    }
+  }
 }
 
-void SymbolTable::enterScope() {
-  currentScope = std::unique_ptr<Scope>{
-      new Scope(std::move(currentScope), changes.size())};
+void SymbolTable::insert(Symbol &sym, Definition *def) {
+  assert(sym.id != Symbol::noId);
+  if (sym.id >= bindings.size()) {
+    bindings.resize(sym.id + 1);
+  }
+  auto &binding = bindings[sym.id];
+  changes.push_back({sym.id, binding});
+  binding.def = def;
+  binding.scope = scopeStarts.size();
 }
 
+void SymbolTable::enterScope() { scopeStarts.push_back(changes.size()); }
+
 void SymbolTable::leaveScope() {
-  while (changes.size() > currentScope->oldSize) {
-    // can't use .resize(oldSize), as that doesn't guarantee the right order
+  size_t start = scopeStarts.back();
+  scopeStarts.pop_back();
+  // undo in reverse order, a symbol may have been inserted more than once
+  while (changes.size() > start) {
+    auto &change = changes.back();
+    bindings[change.symId] = change.prev;
     changes.pop_back();
   }
-  currentScope = std::move(currentScope->parent);
 }
 
 Definition *SymbolTable::lookup(const Symbol &sym) const {
-  return sym.currentDef;
+  return sym.id < bindings.size() ? bindings[sym.id].def : nullptr;
 }
 
 bool SymbolTable::isDefinedInCurrentScope(const Symbol &sym) const {
-  return sym.currentScope == currentScope.get();
+  ScopeDepth scope = sym.id < bindings.size() ? bindings[sym.id].scope : 0;
+  return scope == scopeStarts.size();
 }
 }
@@ -26,10 +26,14 @@
 #ifndef SYMBOLTABLE_H
 #define SYMBOLTABLE_H
 
-#include <deque>
-#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
-#include <unordered_map>
+#include <string>
+#include <vector>
+
+#include "arena.hpp"
 
 namespace ast {
 class Type;
@@ -42,44 +46,110 @@ namespace SymbolTable {
 
 class Definition;
 
-class Scope {
-  friend class SymbolTable;
-  std::unique_ptr<Scope> parent;
-  size_t oldSize;
-
-  Scope(std::unique_ptr<Scope> parent, int parentSize)
-      : parent(std::move(parent)), oldSize(parentSize) {}
-};
+// scopes are numbered by their nesting depth, 0 is outside of any scope
+using ScopeDepth = size_t;
 
+// Symbols don't change once created, so they can be shared between threads.
 class Symbol {
   friend class StringTable;
-  friend class SymbolTable;
-  Scope *currentScope = nullptr;
-  Definition *currentDef = nullptr;
-  explicit Symbol(std::string name) : name(std::move(name)) {}
+  explicit Symbol(std::string name, uint32_t id = noId)
+      : name(std::move(name)), id(id) {}
   friend class ast::DummyDefinition;
   friend class ast::DummySystemOut;
   friend class ast::DummySystemIn;
 
 public:
+  // for symbols which are not in a StringTable
+  static constexpr uint32_t noId = UINT32_MAX;
+
   std::string name;
+  // symbols of a StringTable are numbered 0, 1, 2, ...
+  const uint32_t id;
   Symbol(const Symbol &) = delete;
-  Symbol(Symbol &&o)
-      : currentScope(o.currentScope), currentDef(o.currentDef),
-        name(std::move(o.name)) {}
 };
 
+// Interns strings: returns the same Symbol for equal strings. The symbols
+// live in an arena and never move. They are found through an open addressing
+// table which stores the hash of each entry, so nearly all mismatches are
+// rejected without comparing strings.
 class StringTable {
-  std::unordered_map<std::string, Symbol> symbols;
+public:
+  using Hash = uint64_t;
+  static constexpr Hash emptyHash = UINT64_C(0xcbf29ce484222325);
+
+  // FNV-1a, can be computed incrementally while a string is read
+  static Hash hashStep(Hash hash, char c) {
+    return (hash ^ static_cast<unsigned char>(c)) * UINT64_C(0x100000001b3);
+  }
+  static Hash hashString(const char *str, size_t length,
+                         Hash hash = emptyHash) {
+    for (size_t i = 0; i < length; ++i) {
+      hash = hashStep(hash, str[i]);
+    }
+    return hash;
+  }
+
+private:
+  struct Slot {
+    Hash hash;
+    Symbol *sym; // nullptr for empty slots
+  };
+
+  Arena arena;
+  // size is a power of two, at most half of the slots are used
+  std::vector<Slot> slots;
+  size_t numSymbols = 0;
+  unsigned shift;
+
+  size_t slotIndex(Hash hash) const {
+    // the low bits of FNV-1a are weak, take the top bits of a product
+    return (hash * UINT64_C(0x9e3779b97f4a7c15)) >> shift;
+  }
+  void grow();
 
 public:
+  StringTable();
+  StringTable(const StringTable &) = delete;
+  StringTable &operator=(const StringTable &) = delete;
+  ~StringTable();
+
+  // hash has to be hashString(str, length)
+  Symbol &findOrInsert(const char *str, size_t length, Hash hash) {
+    size_t mask = slots.size() - 1;
+    for (size_t i = slotIndex(hash);; i = (i + 1) & mask) {
+      Slot &slot = slots[i];
+      if (!slot.sym) {
+        if (2 * (numSymbols + 1) > slots.size()) {
+          grow();
+          return findOrInsert(str, length, hash);
+        }
+        slot.hash = hash;
+        slot.sym = new (arena.allocate(sizeof(Symbol), alignof(Symbol)))
+            Symbol(std::string(str, length), numSymbols);
+        ++numSymbols;
+        return *slot.sym;
+      }
+      if (slot.hash == hash && slot.sym->name.size() == length &&
+          std::memcmp(slot.sym->name.data(), str, length) == 0) {
+        return *slot.sym;
+      }
+    }
+  }
   Symbol &findOrInsert(const std::string &name) {
-    auto pos = symbols.find(name);
-    if (pos == symbols.end()) {
-      pos = symbols.emplace(name, Symbol{name}).first;
+    return findOrInsert(name.data(), name.size(),
+                        hashString(name.data(), name.size()));
+  }
+
+  // calls f(symbol, hash) for every symbol
+  template <typename F> void forEachSymbol(F f) {
+    for (auto &slot : slots) {
+      if (slot.sym) {
+        f(*slot.sym, slot.hash);
+      }
     }
-    return pos->second;
   }
+
+  size_t size() const { return numSymbols; }
 };
 
 class Definition {
@@ -88,27 +158,26 @@ public:
   virtual ast::Type *getType() const = 0;
 };
 
+// The current definition of each symbol is stored in a vector indexed by the
+// id of the symbol. Insertions log the previous state, leaving a scope undoes
+// its part of the log. The vectors keep their memory, so once they are big
+// enough for the deepest method nothing is allocated anymore. Each thread
+// uses its own SymbolTable.
 class SymbolTable {
 private:
-  class Change {
-    Symbol &sym;
-    Definition *prevDef;
-    Scope *prevScope;
-
-  public:
-    Change(Symbol &sym, Definition *newDef, Scope *newScope)
-        : sym(sym), prevDef(sym.currentDef), prevScope(sym.currentScope) {
-      sym.currentDef = newDef;
-      sym.currentScope = newScope;
-    }
-    ~Change() {
-      sym.currentDef = prevDef;
-      sym.currentScope = prevScope;
-    }
+  struct Binding {
+    Definition *def = nullptr;
+    ScopeDepth scope = 0;
+  };
+  struct Change {
+    uint32_t symId;
+    Binding prev;
   };
 
-  std::deque<std::unique_ptr<Change>> changes;
-  std::unique_ptr<Scope> currentScope = nullptr;
+  std::vector<Binding> bindings;
+  std::vector<Change> changes;
+  // size of changes when each of the open scopes was entered
+  std::vector<size_t> scopeStarts;
 
 public:
   void enterScope();
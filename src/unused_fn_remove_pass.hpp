@@ -27,6 +27,7 @@ public:
 
 class UnusedFnRmPass : public ProgramPass<UnusedFnRmPass> {
   std::set<ir_graph*> referencedFunctions;
+  unsigned removed = 0;
 
   ir_graph *getGraphForFnName(const std::string &fnName) {
     auto pos = std::find_if(allGraphs.begin(), allGraphs.end(), [&fnName](ir_graph *g) {
@@ -40,6 +41,9 @@ class UnusedFnRmPass : public ProgramPass<UnusedFnRmPass> {
 public:
   UnusedFnRmPass(std::vector<ir_graph *> &graphs) : ProgramPass(graphs) {}
 
+  // inlining may have removed calls since the last run
+  void before() { referencedFunctions.clear(); }
+
   void initWorkList() {
     for (auto& g : allGraphs) {
       if (getGraphFnName(g) == "main"s) {
@@ -71,9 +75,17 @@ public:
         std::remove_if(allGraphs.begin(), allGraphs.end(), [this](ir_graph *g) {
           return referencedFunctions.find(g) == referencedFunctions.end();
         });
+    changed = newEnd != allGraphs.end();
+    removed += allGraphs.end() - newEnd;
     allGraphs.erase(newEnd, allGraphs.end());
   }
 
+  unsigned getNumChanges() const { return removed; }
+
+  static void printStats(std::ostream &out, unsigned numRemoved) {
+    out << "unused-fn: removed " << numRemoved << " methods" << std::endl;
+  }
+
 };
 
 #endif // UNUSED_FN_REMOVE_PASS
@@ -0,0 +1,43 @@
+class Values {
+  public int a;
+  public int b;
+  public int[] arr;
+
+  public int reload() {
+    int x = a;
+    int y = b;
+    int z = a;
+    b = 5;
+    int w = b;
+    a = x + 1;
+    return x + y + z + w + a;
+  }
+
+  public int expressions(int x, int y) {
+    int p = x * y + x / y;
+    int q = x * y - x / y;
+    int r = y * x;
+    if (p > q) {
+      r = r + x * y;
+    }
+    return p + q + r;
+  }
+
+  public int arrays(int i) {
+    arr[i] = arr[i] + 1;
+    arr[i + 1] = arr[i] * 2;
+    return arr[i] + arr[i + 1];
+  }
+
+  public static void main(String[] args) {
+    Values v = new Values();
+    v.a = 3;
+    v.b = 4;
+    v.arr = new int[10];
+    System.out.println(v.reload());
+    System.out.println(v.a);
+    System.out.println(v.expressions(7, 2));
+    System.out.println(v.arrays(3));
+    System.out.println(v.arrays(3));
+  }
+}
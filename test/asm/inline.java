@@ -0,0 +1,72 @@
+class Counter {
+  public int value;
+  public Counter next;
+
+  public int get() {
+    return value;
+  }
+
+  public void set(int v) {
+    value = v;
+  }
+
+  public void add(int v) {
+    set(get() + v);
+  }
+
+  public int abs(int x) {
+    if (x < 0) {
+      return -x;
+    }
+    return x;
+  }
+
+  public int sumTo(int n) {
+    int sum = 0;
+    int i = 0;
+    while (i <= n) {
+      sum = sum + i;
+      i = i + 1;
+    }
+    return sum;
+  }
+
+  public int fib(int n) {
+    if (n < 2) {
+      return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+  }
+
+  public boolean isEven(int n) {
+    if (n == 0) {
+      return true;
+    }
+    return isOdd(n - 1);
+  }
+
+  public boolean isOdd(int n) {
+    if (n == 0) {
+      return false;
+    }
+    return isEven(n - 1);
+  }
+
+  public static void main(String[] args) {
+    Counter c = new Counter();
+    c.next = new Counter();
+    int i = 0;
+    while (i < 10) {
+      c.add(i);
+      c.next.set(c.next.get() - c.abs(i - 5));
+      i = i + 1;
+    }
+    System.out.println(c.get());
+    System.out.println(c.next.get());
+    System.out.println(c.sumTo(100));
+    System.out.println(c.fib(15));
+    if (c.isEven(10) && c.isOdd(7)) {
+      System.out.println(1);
+    }
+  }
+}
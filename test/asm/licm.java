@@ -0,0 +1,66 @@
+class Loops {
+  public int n;
+  public int step;
+  public int total;
+  public int[] values;
+
+  public int sumValues() {
+    int sum = 0;
+    int i = 0;
+    while (i < n) {
+      sum = sum + values[i] * (step + 1);
+      i = i + 1;
+    }
+    return sum;
+  }
+
+  public int countUp() {
+    int i = 0;
+    while (i < n) {
+      total = total + step;
+      i = i + 1;
+    }
+    return total;
+  }
+
+  public int nested(int k) {
+    int result = 0;
+    int i = 0;
+    while (i < n) {
+      int j = 0;
+      while (j < n) {
+        result = result + (k * 3 - step) + values[j];
+        values[j] = values[j] + 1;
+        j = j + 1;
+      }
+      i = i + 1;
+    }
+    return result;
+  }
+
+  public int notEntered(Loops other) {
+    int i = 0;
+    int sum = 0;
+    while (i < 0) {
+      sum = sum + other.n;
+      i = i + 1;
+    }
+    return sum;
+  }
+
+  public static void main(String[] args) {
+    Loops l = new Loops();
+    l.n = 5;
+    l.step = 2;
+    l.values = new int[5];
+    int i = 0;
+    while (i < l.n) {
+      l.values[i] = i * i;
+      i = i + 1;
+    }
+    System.out.println(l.sumValues());
+    System.out.println(l.countUp());
+    System.out.println(l.nested(4));
+    System.out.println(l.notEntered(null));
+  }
+}
@@ -0,0 +1,88 @@
+class Strength {
+  /* 0, but only known at runtime, so divisor + zero is divided with idiv */
+  public int zero;
+  public int mismatches;
+
+  public void checkDiv(int x, int divisor, int quotient, int rest) {
+    if (x / (divisor + zero) != quotient || x % (divisor + zero) != rest) {
+      System.out.println(x);
+      System.out.println(divisor);
+      mismatches = mismatches + 1;
+    }
+  }
+
+  public void checkMul(int x, int factor, int product) {
+    if (x * (factor + zero) != product) {
+      System.out.println(x);
+      System.out.println(factor);
+      mismatches = mismatches + 1;
+    }
+  }
+
+  public void test(int x) {
+    checkDiv(x, 1, x / 1, x % 1);
+    checkDiv(x, -1, x / -1, x % -1);
+    checkDiv(x, 2, x / 2, x % 2);
+    checkDiv(x, -2, x / -2, x % -2);
+    checkDiv(x, 3, x / 3, x % 3);
+    checkDiv(x, 7, x / 7, x % 7);
+    checkDiv(x, -7, x / -7, x % -7);
+    checkDiv(x, 8, x / 8, x % 8);
+    checkDiv(x, -16, x / -16, x % -16);
+    checkDiv(x, 10, x / 10, x % 10);
+    checkDiv(x, 641, x / 641, x % 641);
+    checkDiv(x, 65536, x / 65536, x % 65536);
+    checkDiv(x, 1000000007, x / 1000000007, x % 1000000007);
+    checkDiv(x, 1073741824, x / 1073741824, x % 1073741824);
+    checkDiv(x, 2147483647, x / 2147483647, x % 2147483647);
+    checkDiv(x, -2147483647, x / -2147483647, x % -2147483647);
+    checkDiv(x, -2147483648, x / -2147483648, x % -2147483648);
+
+    checkMul(x, 0, x * 0);
+    checkMul(x, 1, x * 1);
+    checkMul(x, -1, x * -1);
+    checkMul(x, 3, x * 3);
+    checkMul(x, 5, x * 5);
+    checkMul(x, -9, x * -9);
+    checkMul(x, 12, x * 12);
+    checkMul(x, 17, 17 * x);
+    checkMul(x, 31, x * 31);
+    checkMul(x, 100, x * 100);
+    checkMul(x, 1103515245, x * 1103515245);
+    checkMul(x, -2147483648, x * -2147483648);
+  }
+
+  public static void main(String[] args) throws Exception {
+    Strength s = new Strength();
+    s.zero = System.in.read() - 48;
+
+    s.test(-2147483648);
+    s.test(-2147483647);
+    s.test(-1000000007);
+    s.test(-65536);
+    s.test(-641);
+    s.test(-8);
+    s.test(-7);
+    s.test(-1);
+    s.test(0);
+    s.test(1);
+    s.test(6);
+    s.test(7);
+    s.test(123456789);
+    s.test(2147483646);
+    s.test(2147483647);
+    System.out.println(s.mismatches);
+
+    int min = -2147483648;
+    System.out.println(min / 7);
+    System.out.println(min % 7);
+    System.out.println(min / -1);
+    System.out.println(min % -1);
+    System.out.println(min / 8);
+    System.out.println(-9 / 4);
+    System.out.println(-9 % 4);
+    System.out.println(9 % -4);
+    System.out.println(min * 3);
+    System.out.println(123456789 * 10);
+  }
+}
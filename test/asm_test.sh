@@ -2,16 +2,21 @@
 
 compiler=${1}
 in_file=${2}
+# further compiler flags, e.g. --stream
+compiler_flags=${3}
 
 input_file="${2}.in"
 output_file="${2}.out"
+# with --opt-stats, each line is an extended regex which has to match a line
+# of the compiler output
+stats_file="${2}.stats"
 
 
 
 
 out_name=$(mktemp --tmpdir=. -u)
 
-compiler_out=$("${compiler}" "${in_file}" -o $out_name 2>&1)
+compiler_out=$("${compiler}" ${compiler_flags} "${in_file}" -o $out_name 2>&1)
 compiler_retval=$?
 
 
@@ -30,6 +35,21 @@ if [[ ${compiler_retval} -ne 0 ]]; then
   exit 1
 fi
 
+if [[ ${compiler_flags} == *--opt-stats* && -a ${stats_file} ]]; then
+  while read -r pattern; do
+    if ! grep -Eqx "${pattern}" <<< "${compiler_out}"; then
+      echo "ERROR: no line of the optimization statistics matches '${pattern}'"
+
+      echo "Output:"
+      echo "${compiler_out}"
+
+      rm -f $out_name
+
+      exit 1
+    fi
+  done < "${stats_file}"
+fi
+
 
 if [[ -a ${input_file} ]]; then
   a_out=$(cat $input_file | $out_name)
@@ -0,0 +1,93 @@
+#!/bin/bash
+
+# Benchmark for pathologically nested expressions: checks programs with
+# expressions nested 100,000 and 1,000,000 levels deep and fails if the
+# compiler crashes or the time grows clearly faster than linear. The stack
+# is limited to 1 MB, so recursing once per nesting level would crash.
+#
+# Each program is also compiled at a depth of 10,000, which is enough to
+# overflow the stack if building the firm graph recurses per level. Deeper
+# programs can't be compiled with this stack, because the libfirm graph
+# walkers used in lowering and code generation are recursive themselves.
+# -O0 keeps constant folding from flattening the expressions beforehand.
+
+compiler=${1}
+small=100000
+large=1000000
+compile_depth=10000
+
+tmp_dir=$(mktemp -d)
+trap 'rm -rf "${tmp_dir}"' EXIT
+
+repeat() {
+  yes -- "${1}" | head -n "${2}" | tr -d '\n'
+}
+
+statement() {
+  local n=${2}
+  case ${1} in
+    add_chain)     echo "x = $(repeat '1 + ' ${n})1;" ;;
+    right_chain)   echo "x = $(repeat '1 + (' ${n})1$(repeat ')' ${n});" ;;
+    assign_chain)  echo "x = $(repeat 'x = ' ${n})1;" ;;
+    and_chain)     echo "b = $(repeat 'b && ' ${n})true;" ;;
+    parentheses)   echo "x = $(repeat '(' ${n})1$(repeat ')' ${n});" ;;
+    negations)     echo "x = $(repeat '- ' ${n})1;" ;;
+    nots)          echo "b = $(repeat '!' ${n})true;" ;;
+    array_index)   echo "x = $(repeat 'a[' ${n})0$(repeat ']' ${n});" ;;
+    calls)         echo "x = $(repeat 'f(' ${n})1$(repeat ')' ${n});" ;;
+  esac
+}
+
+program() {
+  echo "class Main {"
+  echo "  public int[] a;"
+  echo "  public int f(int x) { return x; }"
+  echo "  public void run() {"
+  echo "    int x; boolean b; a = new int[1];"
+  statement "${1}" "${2}"
+  echo "  }"
+  echo "  public static void main(String[] args) { new Main().run(); }"
+  echo "}"
+}
+
+# prints the run time in milliseconds, fails if the compiler fails. Further
+# arguments are passed to the compiler, the default is --check
+run() {
+  local file="${tmp_dir}/${1}_${2}.java"
+  program "${1}" "${2}" > "${file}"
+  local flags=("${@:3}")
+  (( ${#flags[@]} )) || flags=(--check)
+  local start=$(date +%s%N)
+  local out
+  out=$(ulimit -s 1024 && "${compiler}" "${flags[@]}" "${file}" 2>&1)
+  local retval=$?
+  local end=$(date +%s%N)
+  if [[ ${retval} -ne 0 ]]; then
+    echo "ERROR: Compiler returned ${retval} for ${1} with depth ${2}" \
+         "(${flags[*]})" >&2
+    echo "${out}" | head -n 20 >&2
+    return 1
+  fi
+  echo $(( (end - start) / 1000000 ))
+}
+
+failed=0
+printf "%-14s %12s %12s %12s\n" "expression" "${small}" "${large}" \
+       "compile ${compile_depth}"
+for shape in add_chain right_chain assign_chain and_chain parentheses \
+             negations nots array_index calls; do
+  small_ms=$(run ${shape} ${small}) || { failed=1; continue; }
+  large_ms=$(run ${shape} ${large}) || { failed=1; continue; }
+  compile_ms=$(run ${shape} ${compile_depth} -O0 -o "${tmp_dir}/a.out") ||
+    { failed=1; continue; }
+  printf "%-14s %10sms %10sms %10sms\n" ${shape} ${small_ms} ${large_ms} \
+         ${compile_ms}
+  # 10 times the depth, allow a factor of 30 for noise and caches
+  (( small_ms < 10 )) && small_ms=10
+  if (( large_ms > 30 * small_ms )); then
+    echo "ERROR: ${shape} does not scale linearly with the nesting depth"
+    failed=1
+  fi
+done
+
+exit ${failed}
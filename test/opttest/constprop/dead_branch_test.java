@@ -0,0 +1,31 @@
+class Test {
+  public int x;
+  public boolean count() {
+    x = x + 1;
+    return true;
+  }
+  public int foo() {
+    if (false) {
+      return 1;
+    }
+    while (1 > 2) {
+      x = 100;
+    }
+    if (false && count()) {
+      x = 200;
+    } else if (true || count()) {
+      x = x + 10;
+    }
+    if (count() && true) {
+      x = x + 1000;
+    }
+    if (!(3 <= 3)) {
+      return 2;
+    } else {
+      return x;
+    }
+  }
+  public static void main(String[] args){
+    System.out.println(new Test().foo());
+  }
+}
@@ -0,0 +1,13 @@
+class Test {
+  public static void main(String[] args){
+    System.out.println(2147483647 + 1);
+    System.out.println(-2147483648 - 1);
+    System.out.println(65536 * 65536 + 46341 * 46341);
+    System.out.println(-2147483648 / -1);
+    System.out.println(-2147483648 % -1);
+    System.out.println(-(-2147483648));
+    System.out.println(-7 / 2);
+    System.out.println(-7 % 3);
+    System.out.println(7 % -3);
+  }
+}
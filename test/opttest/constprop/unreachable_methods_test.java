@@ -0,0 +1,33 @@
+class Test {
+  public Lib lib;
+  public int even(int x) {
+    if (x == 0) return 1;
+    return odd(x - 1);
+  }
+  public int odd(int x) {
+    if (x == 0) return 0;
+    return even(x - 1);
+  }
+  public int unused(int x) {
+    return lib.unusedToo(x) + even(x);
+  }
+  public static void main(String[] args){
+    Test t = new Test();
+    t.lib = new Lib();
+    System.out.println(t.even(10));
+    System.out.println(t.lib.used(new int[3]));
+  }
+}
+class Lib {
+  public int used(int[] a) {
+    a[1] = 5;
+    return a[1] + a[0];
+  }
+  public int unusedToo(int x) {
+    return used(new int[x]);
+  }
+}
+class Unused {
+  public int f() { return new Unused().g(); }
+  public int g() { return f(); }
+}